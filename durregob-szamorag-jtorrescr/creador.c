@@ -3,30 +3,264 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <math.h>
 
 #define HASH_SIZE 1000
 #define MAX_TITLE 256
 #define MAX_ARTIST 256
 #define MAX_ALBUM 256
 #define MAX_LINE 1024
+#define MPH_FILENAME "songs_name.mph"
+#define MPH_MAGIC 0x3148504D // "MPH1"
+#define MPH_KEYS_PER_BUCKET 4
+#define BLOOM_FILENAME "songs_name.bloom"
+#define BLOOM_MAGIC 0x314D4C42 // "BLM1"
+#define BLOOM_BITS_PER_KEY 10
+#define BLOOM_HASHES 7
+#define BLOOM_BLOCK_WORDS 8    // Bloques de 512 bits (una línea de caché)
+#define DIR_FILENAME "songs_database.dir"
+#define DIR_MAGIC 0x31524944 // "DIR1"
+#define SORT_FILENAME "songs_database.sort"
+#define SORT_MAGIC 0x31545253 // "SRT1"
+#define ORDER_FIELDS 5       // energía, bailabilidad, tempo, duración, año
+#define FUZZY_FILENAME "songs_name.fuzzy"
+#define FUZZY_MAGIC 0x31595A46 // "FZY1"
+#define FUZZY_PREFIX 7         // Solo se generan borrados del prefijo (SymSpell)
+#define FUZZY_MAX_EDITS 2
+#define FUZZY_MAX_DELETES 32   // 1 + 7 + 21 para un prefijo de 7
+#define VEC_FILENAME "songs_database.vec"
+#define VEC_MAGIC 0x31434556 // "VEC1"
+#define VEC_DIMS 4             // bailabilidad, energía, tempo, duración
+#define COMPLETE_FILENAME "songs_names.complete"
+#define COMPLETE_MAGIC 0x31504D43 // "CMP1"
+#define COMPLETE_TOP 16          // Sugerencias guardadas por prefijo frecuente
+#define COMPLETE_HOT_PREFIX 3    // Longitud máxima (en bytes) de los prefijos precalculados
+#define COMPLETE_HOT_MIN 64      // Rango mínimo para precalcular un prefijo
+#define COMPLETE_KIND_NAME 0
+#define COMPLETE_KIND_ARTIST 1
+#define COL_FILENAME "songs_database.col"
+#define COL_MAGIC 0x324C4F43 // "COL2"
+#define COL_BLOCK_SIZE 4096      // Bloques de texto independientes (pequeños: cada texto pide su bloque)
+#define COL_COMPRESSED 1         // Bloques comprimidos en formato de bloque LZ4
+#define LZ4_HASH_BITS 12
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5      // Reglas del formato: los últimos bytes van como literales
+#define LZ4_MATCH_LIMIT 12
 
-typedef struct Song {
+// Registro en disco: álbum y artistas son identificadores de los
+// diccionarios de songs_database.col (el texto se guarda una sola vez)
+typedef struct SongRecord {
     char id[64];
     char name[MAX_TITLE];
-    char album[MAX_ALBUM];
-    char artists[MAX_ARTIST];
+    uint32_t album_id;
+    uint32_t artist_id;
     int year;
     int duration_ms;
     double danceability;
     double energy;
     double tempo;
     long next;
-} Song;
+} SongRecord;
 
 typedef struct HashEntry {
     long first_position;
 } HashEntry;
 
+// Cabecera del índice de hash perfecto mínimo sobre nombres normalizados
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t record_count;  // Registros de la base al construir el índice
+    uint64_t key_count;     // Nombres distintos = número de ranuras
+    uint64_t bucket_count;
+    uint64_t group_count;   // Posiciones en la lista de duplicados
+} MphHeader;
+
+// Desplazamiento por bucket: ranura = (f1 + d0 * f2 + d1) % key_count
+typedef struct {
+    uint32_t d0;
+    uint32_t d1;
+} MphDisplacement;
+
+// Ranura: si count == 1, position es el registro; si no, apunta a la
+// lista de posiciones de los duplicados
+typedef struct {
+    uint32_t fingerprint;
+    uint32_t count;
+    int64_t position;
+} MphSlot;
+
+// Cabecera del filtro de Bloom por bloques sobre nombres normalizados
+typedef struct {
+    uint32_t magic;
+    uint32_t hashes;
+    uint64_t record_count;
+    uint64_t block_count;
+} BloomHeader;
+
+// Directorio de la base agrupada: un tramo (offset, count) por bucket
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t record_count;
+} DirHeader;
+
+typedef struct {
+    int64_t offset;
+    int64_t count;
+} BucketRun;
+
+// Índice ordenado: ORDER_FIELDS bloques de record_count entradas cada uno
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t record_count;
+    uint64_t field_count;
+} SortHeader;
+
+typedef struct {
+    double value;
+    int32_t year;      // Permite filtrar por año sin leer el registro
+    int32_t reserved;
+    int64_t position;
+} SortEntry;
+
+// Diccionario de borrados (SymSpell) sobre nombres normalizados
+typedef struct {
+    uint32_t magic;
+    uint32_t prefix_length;
+    uint64_t record_count;
+    uint64_t name_count;
+    uint64_t pair_count;
+    uint64_t position_count;
+    uint64_t heap_size;
+} FuzzyHeader;
+
+// Borrado -> nombre; ordenado por hash para búsqueda binaria
+typedef struct {
+    uint32_t hash;
+    uint32_t name_id;
+} FuzzyPair;
+
+// Nombre distinto: texto en el heap y sus posiciones de registro
+typedef struct {
+    uint32_t text_offset;
+    uint32_t length;
+    uint32_t count;
+    uint32_t first_position;
+} FuzzyName;
+
+typedef struct {
+    char *name;
+    long position;
+} NamePosition;
+
+// Índice de vectores cuantizados para "canciones similares"
+typedef struct {
+    uint32_t magic;
+    uint32_t dims;
+    uint64_t record_count;
+    float min[VEC_DIMS];     // Valor = min + código / scale
+    float scale[VEC_DIMS];
+} VecHeader;
+
+// Identificador -> fila, ordenado por hash del identificador
+typedef struct {
+    uint64_t hash;
+    uint64_t row;
+} VecIdEntry;
+
+// Índice de autocompletado: términos distintos (nombres y artistas)
+// ordenados por su forma en minúsculas, más los mejores por prefijo corto
+typedef struct {
+    uint32_t magic;
+    uint32_t top;
+    uint64_t record_count;
+    uint64_t entry_count;
+    uint64_t hot_count;
+    uint64_t heap_size;
+} CompleteHeader;
+
+typedef struct {
+    uint32_t text_offset;
+    uint16_t length;
+    uint8_t kind;            // COMPLETE_KIND_NAME o COMPLETE_KIND_ARTIST
+    uint8_t reserved;
+    uint32_t count;          // Canciones con este término (popularidad)
+    int32_t year;            // Año más reciente (desempate)
+} CompleteEntry;
+
+// Prefijo frecuente y sus mejores términos (UINT32_MAX = vacío)
+typedef struct {
+    char prefix[COMPLETE_HOT_PREFIX + 1];
+    uint32_t top[COMPLETE_TOP];
+} CompleteHot;
+
+// Término de una canción antes de agrupar
+typedef struct {
+    char *key;               // Minúsculas, define el orden
+    char *text;              // Forma original que se muestra
+    int kind;
+    int year;
+} CompleteTerm;
+
+typedef struct {
+    CompleteTerm *items;
+    long count;
+    long capacity;
+} CompleteTermList;
+
+// Columnas codificadas por diccionario (artistas y álbum) y columnas
+// numéricas empaquetadas, en el mismo orden de filas que la base
+typedef struct {
+    uint32_t magic;
+    uint32_t flags;
+    uint64_t record_count;
+    uint64_t artist_count;
+    uint64_t album_count;
+    uint64_t block_count;
+    uint64_t heap_size;      // Bytes de los bloques de texto en disco
+} ColumnHeader;
+
+// Entrada de diccionario: texto dentro de un bloque descomprimido
+typedef struct {
+    uint32_t offset;
+    uint16_t length;
+    uint16_t block;
+} ColumnString;
+
+// Bloque de texto: stored_size == raw_size indica que no está comprimido
+typedef struct {
+    uint64_t offset;         // Desde el inicio de los bloques
+    uint32_t stored_size;
+    uint32_t raw_size;
+} ColumnBlock;
+
+// Valor de una columna de texto antes de codificarla
+typedef struct {
+    char *text;
+    long row;
+} ColumnValue;
+
+// Columna de texto del CSV codificada por diccionario
+typedef struct {
+    ColumnValue *values;     // Una por canción; dueños de los textos
+    long count;
+    long capacity;
+    char **texts;            // Textos distintos en orden de strcmp
+    uint32_t text_count;
+    uint32_t *ids;           // Identificador de cada canción, en orden de carga
+} TextDictionary;
+
+// Par (hash, posición) usado al construir el índice
+typedef struct {
+    uint64_t hash;
+    long position;
+    long rank;      // Orden del registro en el recorrido de las cadenas
+} KeyPosition;
+
 // Función hash mejorada para nombres de canciones
 int hash_function(const char *name) {
     unsigned long hash = 5381;
@@ -39,6 +273,35 @@ int hash_function(const char *name) {
     return hash % HASH_SIZE;
 }
 
+// Hash de 64 bits (FNV-1a) del nombre normalizado a minúsculas
+uint64_t name_hash64(const char *name) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    
+    while (*name) {
+        hash ^= (uint64_t)tolower((unsigned char)*name++);
+        hash *= 0x100000001b3ull;
+    }
+    
+    return hash;
+}
+
+// Mezclador de bits (finalizador de splitmix64)
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+// Ranura de una clave con el desplazamiento de su bucket
+uint64_t mph_slot(uint64_t hash, const MphDisplacement *disp, uint64_t key_count) {
+    uint64_t f1 = mix64(hash ^ 0x9e3779b97f4a7c15ull) % key_count;
+    uint64_t f2 = key_count > 1 ? 1 + mix64(hash ^ 0xc2b2ae3d27d4eb4full) % (key_count - 1) : 0;
+    return (f1 + (disp->d0 * f2) % key_count + disp->d1) % key_count;
+}
+
 // Función para eliminar comillas externas y limpiar el campo
 void clean_field(char *field) {
     int len = strlen(field);
@@ -91,6 +354,65 @@ int parse_csv_line(char *line, char *fields[], int max_fields) {
     return field_count;
 }
 
+int compare_column_values(const void *a, const void *b) {
+    const ColumnValue *va = a, *vb = b;
+    int cmp = strcmp(va->text, vb->text);
+    if (cmp != 0) return cmp;
+    return va->row < vb->row ? -1 : (va->row > vb->row);
+}
+
+// Codificar una columna de texto: ordena los valores, asigna un
+// identificador a cada texto distinto y deja los distintos en dict
+uint32_t build_dictionary(ColumnValue *values, long count, uint32_t *ids, char **dict) {
+    qsort(values, count, sizeof(ColumnValue), compare_column_values);
+    
+    uint32_t distinct = 0;
+    for (long i = 0; i < count; i++) {
+        if (i == 0 || strcmp(values[i].text, values[i - 1].text) != 0) {
+            dict[distinct++] = values[i].text;
+        }
+        ids[values[i].row] = distinct - 1;
+    }
+    return distinct;
+}
+
+// Agregar el texto de una canción (recortado como en los campos de 256 bytes)
+int dictionary_add(TextDictionary *dict, const char *text, size_t size) {
+    if (dict->count == dict->capacity) {
+        long capacity = dict->capacity ? dict->capacity * 2 : 1024;
+        ColumnValue *values = realloc(dict->values, sizeof(ColumnValue) * capacity);
+        if (!values) return 0;
+        dict->values = values;
+        dict->capacity = capacity;
+    }
+    
+    ColumnValue *value = &dict->values[dict->count];
+    value->text = strndup(text, size - 1);
+    value->row = dict->count;
+    if (!value->text) return 0;
+    dict->count++;
+    return 1;
+}
+
+// Asignar los identificadores una vez agregadas todas las canciones
+int dictionary_build(TextDictionary *dict) {
+    dict->texts = malloc(sizeof(char*) * (dict->count + 1));
+    dict->ids = malloc(sizeof(uint32_t) * (dict->count + 1));
+    if (!dict->texts || !dict->ids) return 0;
+    dict->text_count = build_dictionary(dict->values, dict->count, dict->ids, dict->texts);
+    return 1;
+}
+
+void dictionary_free(TextDictionary *dict) {
+    for (long i = 0; i < dict->count; i++) {
+        free(dict->values[i].text);
+    }
+    free(dict->values);
+    free(dict->texts);
+    free(dict->ids);
+    memset(dict, 0, sizeof(TextDictionary));
+}
+
 // Crear archivo binario inicial
 void create_binary_file(const char *filename) {
     FILE *file = fopen(filename, "wb");
@@ -115,7 +437,7 @@ void create_binary_file(const char *filename) {
 
 // Agregar canción al archivo
 void add_song(const char *filename, const char *id, const char *name, 
-              const char *album, const char *artists, int year, 
+              uint32_t album_id, uint32_t artist_id, int year, 
               int duration_ms, double danceability, double energy, double tempo) {
     FILE *file = fopen(filename, "r+b");
     if (!file) {
@@ -133,19 +455,15 @@ void add_song(const char *filename, const char *id, const char *name,
     
     int hash_index = hash_function(name);
     
-    Song new_song;
+    SongRecord new_song;
     strncpy(new_song.id, id, sizeof(new_song.id) - 1);
     new_song.id[sizeof(new_song.id) - 1] = '\0';
     
     strncpy(new_song.name, name, sizeof(new_song.name) - 1);
     new_song.name[sizeof(new_song.name) - 1] = '\0';
     
-    strncpy(new_song.album, album, sizeof(new_song.album) - 1);
-    new_song.album[sizeof(new_song.album) - 1] = '\0';
-    
-    strncpy(new_song.artists, artists, sizeof(new_song.artists) - 1);
-    new_song.artists[sizeof(new_song.artists) - 1] = '\0';
-    
+    new_song.album_id = album_id;
+    new_song.artist_id = artist_id;
     new_song.year = year;
     new_song.duration_ms = duration_ms;
     new_song.danceability = danceability;
@@ -156,7 +474,7 @@ void add_song(const char *filename, const char *id, const char *name,
     fseek(file, 0, SEEK_END);
     long new_position = ftell(file);
     
-    size_t written = fwrite(&new_song, sizeof(Song), 1, file);
+    size_t written = fwrite(&new_song, sizeof(SongRecord), 1, file);
     if (written != 1) {
         printf("Error escribiendo canción\n");
         fclose(file);
@@ -174,12 +492,50 @@ void add_song(const char *filename, const char *id, const char *name,
     fclose(file);
 }
 
-// Función para cargar canciones desde el archivo CSV específico
-void load_songs_from_csv(const char *csv_filename, const char *bin_filename) {
+// Primera pasada por el CSV: el álbum y los artistas de cada canción
+// válida, para codificarlos por diccionario antes de escribir los registros
+int collect_text_columns(const char *csv_filename, TextDictionary *artists,
+                         TextDictionary *albums) {
     FILE *csv_file = fopen(csv_filename, "r");
     if (!csv_file) {
         printf("Error abriendo archivo CSV: %s\n", csv_filename);
-        return;
+        return 0;
+    }
+    
+    char line[MAX_LINE];
+    int ok = fgets(line, sizeof(line), csv_file) != NULL; // Cabecera
+    while (ok && fgets(line, sizeof(line), csv_file)) {
+        line[strcspn(line, "\n")] = 0;
+        char *fields[25];
+        int field_count = parse_csv_line(line, fields, 25);
+        
+        // Mismas reglas que la carga de registros
+        if (field_count >= 24 && strlen(fields[1]) > 0 && atoi(fields[23]) > 0) {
+            ok = dictionary_add(artists, fields[4], MAX_ARTIST) &&
+                 dictionary_add(albums, fields[2], MAX_ALBUM);
+        }
+    }
+    fclose(csv_file);
+    
+    if (!ok || !dictionary_build(artists) || !dictionary_build(albums)) {
+        printf("Error: memoria insuficiente para los diccionarios de texto\n");
+        return 0;
+    }
+    printf("Diccionarios: %u artistas y %u álbumes distintos\n",
+           artists->text_count, albums->text_count);
+    return 1;
+}
+
+// Función para cargar canciones desde el archivo CSV específico. El álbum y
+// los artistas se guardan como identificadores de los diccionarios
+int load_songs_from_csv(const char *csv_filename, const char *bin_filename,
+                        TextDictionary *artists, TextDictionary *albums) {
+    if (!collect_text_columns(csv_filename, artists, albums)) return 0;
+    
+    FILE *csv_file = fopen(csv_filename, "r");
+    if (!csv_file) {
+        printf("Error abriendo archivo CSV: %s\n", csv_filename);
+        return 0;
     }
     
     char line[MAX_LINE];
@@ -190,7 +546,7 @@ void load_songs_from_csv(const char *csv_filename, const char *bin_filename) {
     if (!fgets(line, sizeof(line), csv_file)) {
         printf("Error leyendo cabecera del CSV\n");
         fclose(csv_file);
-        return;
+        return 0;
     }
     
     printf("Procesando archivo CSV...\n");
@@ -207,8 +563,6 @@ void load_songs_from_csv(const char *csv_filename, const char *bin_filename) {
         if (field_count >= 24) { // Deberíamos tener al menos 24 campos
             char *id = fields[0];
             char *name = fields[1];
-            char *album = fields[2];
-            char *artists = fields[4]; // artists está en posición 4
             char *year_str = fields[23];
             char *duration_str = fields[20];
             char *danceability_str = fields[9];
@@ -224,7 +578,11 @@ void load_songs_from_csv(const char *csv_filename, const char *bin_filename) {
             
             // Validar datos básicos
             if (strlen(name) > 0 && year > 0) {
-                add_song(bin_filename, id, name, album, artists, year, 
+                if (count >= artists->count) {
+                    printf("Error: el CSV cambió durante la carga\n");
+                    break;
+                }
+                add_song(bin_filename, id, name, albums->ids[count], artists->ids[count], year, 
                         duration_ms, danceability, energy, tempo);
                 count++;
                 
@@ -246,6 +604,1206 @@ void load_songs_from_csv(const char *csv_filename, const char *bin_filename) {
     printf("\n=== RESUMEN DE CARGA ===\n");
     printf("Canciones procesadas exitosamente: %d\n", count);
     printf("Líneas con errores: %d\n", error_count);
+    return count == artists->count;
+}
+
+// Número de registros de canciones en el archivo binario
+long count_records(FILE *file) {
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file) - (long)(sizeof(HashEntry) * HASH_SIZE);
+    return size > 0 ? size / (long)sizeof(SongRecord) : 0;
+}
+
+int compare_key_positions(const void *a, const void *b) {
+    const KeyPosition *ka = a, *kb = b;
+    if (ka->hash != kb->hash) return ka->hash < kb->hash ? -1 : 1;
+    return ka->rank < kb->rank ? -1 : (ka->rank > kb->rank);
+}
+
+// Reorganizar la base: los registros de cada bucket quedan contiguos y en
+// el orden de su cadena; "next" apunta al registro siguiente del tramo y el
+// directorio (offset, count) permite leer cada bucket de una sola vez
+void cluster_database(const char *bin_filename, const char *dir_filename) {
+    FILE *file = fopen(bin_filename, "rb");
+    if (!file) {
+        printf("Error abriendo archivo\n");
+        return;
+    }
+    
+    HashEntry hash_table[HASH_SIZE];
+    if (fread(hash_table, sizeof(HashEntry), HASH_SIZE, file) != HASH_SIZE) {
+        printf("Error leyendo tabla hash\n");
+        fclose(file);
+        return;
+    }
+    long record_count = count_records(file);
+    
+    char tmp_filename[512];
+    snprintf(tmp_filename, sizeof(tmp_filename), "%s.tmp", bin_filename);
+    FILE *out = fopen(tmp_filename, "wb");
+    if (!out) {
+        printf("Error creando archivo %s\n", tmp_filename);
+        fclose(file);
+        return;
+    }
+    
+    // Reservar espacio para la tabla hash; se reescribe al final
+    HashEntry new_table[HASH_SIZE];
+    BucketRun runs[HASH_SIZE];
+    fwrite(hash_table, sizeof(HashEntry), HASH_SIZE, out);
+    
+    long out_position = sizeof(HashEntry) * HASH_SIZE;
+    long written = 0;
+    bool ok = true;
+    
+    for (int i = 0; i < HASH_SIZE && ok; i++) {
+        runs[i].offset = out_position;
+        runs[i].count = 0;
+        long current_pos = hash_table[i].first_position;
+        
+        while (current_pos != -1 && written < record_count) {
+            SongRecord song;
+            fseek(file, current_pos, SEEK_SET);
+            if (fread(&song, sizeof(SongRecord), 1, file) != 1) {
+                printf("Error leyendo canción en posición %ld\n", current_pos);
+                ok = false;
+                break;
+            }
+            current_pos = song.next;
+            song.next = current_pos != -1 ? out_position + (long)sizeof(SongRecord) : -1;
+            
+            if (fwrite(&song, sizeof(SongRecord), 1, out) != 1) {
+                printf("Error escribiendo canción\n");
+                ok = false;
+                break;
+            }
+            out_position += sizeof(SongRecord);
+            runs[i].count++;
+            written++;
+        }
+        
+        new_table[i].first_position = runs[i].count > 0 ? runs[i].offset : -1;
+    }
+    fclose(file);
+    
+    if (ok && written != record_count) {
+        printf("Error: las cadenas cubren %ld de %ld registros\n", written, record_count);
+        ok = false;
+    }
+    
+    fseek(out, 0, SEEK_SET);
+    fwrite(new_table, sizeof(HashEntry), HASH_SIZE, out);
+    if (fclose(out) != 0 || !ok || rename(tmp_filename, bin_filename) != 0) {
+        printf("Error reorganizando la base; se conserva el archivo original\n");
+        remove(tmp_filename);
+        return;
+    }
+    
+    FILE *dir = fopen(dir_filename, "wb");
+    if (!dir) {
+        printf("Error creando archivo %s\n", dir_filename);
+        return;
+    }
+    DirHeader header = {DIR_MAGIC, 1, (uint64_t)record_count};
+    fwrite(&header, sizeof(header), 1, dir);
+    fwrite(runs, sizeof(BucketRun), HASH_SIZE, dir);
+    if (fclose(dir) != 0) {
+        printf("Error escribiendo directorio de buckets\n");
+        return;
+    }
+    
+    printf("\nBase reorganizada por bucket: %ld registros contiguos (%s)\n",
+           record_count, dir_filename);
+}
+
+int compare_sort_entries(const void *a, const void *b) {
+    const SortEntry *ea = a, *eb = b;
+    if (ea->value != eb->value) return ea->value < eb->value ? -1 : 1;
+    return ea->position < eb->position ? -1 : (ea->position > eb->position);
+}
+
+// Valor de un registro en el campo de orden (mismo orden que ORDER_* de la búsqueda)
+double song_field_value(const SongRecord *song, int field) {
+    switch (field) {
+        case 0: return song->energy;
+        case 1: return song->danceability;
+        case 2: return song->tempo;
+        case 3: return song->duration_ms;
+        default: return song->year;
+    }
+}
+
+// Construir el índice ordenado por cada campo numérico: permite responder
+// ORDER BY ... LIMIT K deteniéndose en cuanto se tienen K coincidencias
+void build_sort_index(const char *bin_filename, const char *sort_filename) {
+    FILE *file = fopen(bin_filename, "rb");
+    if (!file) {
+        printf("Error abriendo archivo\n");
+        return;
+    }
+    
+    long record_count = count_records(file);
+    double *values = malloc(sizeof(double) * ORDER_FIELDS * (record_count + 1));
+    int32_t *years = malloc(sizeof(int32_t) * (record_count + 1));
+    SortEntry *entries = malloc(sizeof(SortEntry) * (record_count + 1));
+    if (!values || !years || !entries) {
+        printf("Error: memoria insuficiente para el índice ordenado\n");
+        free(values);
+        free(years);
+        free(entries);
+        fclose(file);
+        return;
+    }
+    
+    fseek(file, sizeof(HashEntry) * HASH_SIZE, SEEK_SET);
+    SongRecord song;
+    long count = 0;
+    while (count < record_count && fread(&song, sizeof(SongRecord), 1, file) == 1) {
+        for (int f = 0; f < ORDER_FIELDS; f++) {
+            values[count * ORDER_FIELDS + f] = song_field_value(&song, f);
+        }
+        years[count] = song.year;
+        count++;
+    }
+    fclose(file);
+    
+    FILE *out = fopen(sort_filename, "wb");
+    if (!out) {
+        printf("Error creando archivo %s\n", sort_filename);
+    } else {
+        SortHeader header = {SORT_MAGIC, 1, (uint64_t)count, ORDER_FIELDS};
+        fwrite(&header, sizeof(header), 1, out);
+        
+        for (int f = 0; f < ORDER_FIELDS; f++) {
+            for (long i = 0; i < count; i++) {
+                entries[i].value = values[i * ORDER_FIELDS + f];
+                entries[i].year = years[i];
+                entries[i].reserved = 0;
+                entries[i].position = (long)(sizeof(HashEntry) * HASH_SIZE) + i * (long)sizeof(SongRecord);
+            }
+            qsort(entries, count, sizeof(SortEntry), compare_sort_entries);
+            fwrite(entries, sizeof(SortEntry), count, out);
+        }
+        
+        if (fclose(out) != 0) {
+            printf("Error escribiendo índice ordenado\n");
+        } else {
+            printf("\nÍndice ordenado por %d campos: %s (%ld entradas por campo)\n",
+                   ORDER_FIELDS, sort_filename, count);
+        }
+    }
+    
+    free(values);
+    free(years);
+    free(entries);
+}
+
+// Hash de 32 bits (FNV-1a) de un borrado
+uint32_t delete_hash32(const char *text) {
+    uint32_t hash = 2166136261u;
+    while (*text) {
+        hash ^= (unsigned char)*text++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Borrados de hasta FUZZY_MAX_EDITS caracteres del prefijo de la palabra
+// (incluida la palabra sin cambios), sin repetidos
+int fuzzy_deletes(const char *word, char deletes[][FUZZY_PREFIX + 1]) {
+    size_t length = strlen(word);
+    if (length > FUZZY_PREFIX) length = FUZZY_PREFIX;
+    
+    memcpy(deletes[0], word, length);
+    deletes[0][length] = '\0';
+    int count = 1;
+    int level_start = 0;
+    
+    for (int edit = 0; edit < FUZZY_MAX_EDITS; edit++) {
+        int level_end = count;
+        for (int i = level_start; i < level_end; i++) {
+            size_t len = strlen(deletes[i]);
+            for (size_t k = 0; k < len && count < FUZZY_MAX_DELETES; k++) {
+                char candidate[FUZZY_PREFIX + 1];
+                memcpy(candidate, deletes[i], k);
+                memcpy(candidate + k, deletes[i] + k + 1, len - k);
+                
+                int j;
+                for (j = 0; j < count && strcmp(deletes[j], candidate) != 0; j++);
+                if (j == count) strcpy(deletes[count++], candidate);
+            }
+        }
+        level_start = level_end;
+    }
+    
+    return count;
+}
+
+int compare_name_positions(const void *a, const void *b) {
+    const NamePosition *na = a, *nb = b;
+    int cmp = strcmp(na->name, nb->name);
+    if (cmp != 0) return cmp;
+    return na->position < nb->position ? -1 : (na->position > nb->position);
+}
+
+int compare_fuzzy_pairs(const void *a, const void *b) {
+    const FuzzyPair *pa = a, *pb = b;
+    if (pa->hash != pb->hash) return pa->hash < pb->hash ? -1 : 1;
+    return pa->name_id < pb->name_id ? -1 : (pa->name_id > pb->name_id);
+}
+
+// Construir el diccionario de borrados para búsqueda aproximada (distancia
+// de edición <= 2): cada nombre aporta los borrados de su prefijo
+void build_fuzzy_index(const char *bin_filename, const char *fuzzy_filename) {
+    FILE *file = fopen(bin_filename, "rb");
+    if (!file) {
+        printf("Error abriendo archivo\n");
+        return;
+    }
+    
+    long record_count = count_records(file);
+    NamePosition *records = malloc(sizeof(NamePosition) * (record_count + 1));
+    if (!records) {
+        printf("Error: memoria insuficiente para el índice aproximado\n");
+        fclose(file);
+        return;
+    }
+    
+    fseek(file, sizeof(HashEntry) * HASH_SIZE, SEEK_SET);
+    SongRecord song;
+    long count = 0;
+    while (count < record_count && fread(&song, sizeof(SongRecord), 1, file) == 1) {
+        for (int i = 0; song.name[i]; i++) {
+            song.name[i] = tolower((unsigned char)song.name[i]);
+        }
+        records[count].name = strdup(song.name);
+        records[count].position = (long)(sizeof(HashEntry) * HASH_SIZE) + count * (long)sizeof(SongRecord);
+        if (!records[count].name) break;
+        count++;
+    }
+    fclose(file);
+    
+    qsort(records, count, sizeof(NamePosition), compare_name_positions);
+    
+    // Nombres distintos, con sus posiciones agrupadas
+    FuzzyName *names = malloc(sizeof(FuzzyName) * (count + 1));
+    FuzzyPair *pairs = malloc(sizeof(FuzzyPair) * (count + 1) * FUZZY_MAX_DELETES);
+    uint64_t name_count = 0;
+    uint64_t pair_count = 0;
+    uint64_t heap_size = 0;
+    
+    if (names && pairs) {
+        for (long i = 0; i < count; i++) {
+            if (i > 0 && strcmp(records[i].name, records[i - 1].name) == 0) {
+                names[name_count - 1].count++;
+                continue;
+            }
+            
+            FuzzyName *entry = &names[name_count];
+            entry->text_offset = (uint32_t)heap_size;
+            entry->length = (uint32_t)strlen(records[i].name);
+            entry->count = 1;
+            entry->first_position = (uint32_t)i;
+            heap_size += entry->length + 1;
+            
+            char deletes[FUZZY_MAX_DELETES][FUZZY_PREFIX + 1];
+            int delete_count = fuzzy_deletes(records[i].name, deletes);
+            for (int d = 0; d < delete_count; d++) {
+                pairs[pair_count].hash = delete_hash32(deletes[d]);
+                pairs[pair_count].name_id = (uint32_t)name_count;
+                pair_count++;
+            }
+            name_count++;
+        }
+        
+        qsort(pairs, pair_count, sizeof(FuzzyPair), compare_fuzzy_pairs);
+        
+        FILE *out = fopen(fuzzy_filename, "wb");
+        if (!out) {
+            printf("Error creando archivo %s\n", fuzzy_filename);
+        } else {
+            FuzzyHeader header = {FUZZY_MAGIC, FUZZY_PREFIX, (uint64_t)count, name_count,
+                                  pair_count, (uint64_t)count, heap_size};
+            fwrite(&header, sizeof(header), 1, out);
+            fwrite(pairs, sizeof(FuzzyPair), pair_count, out);
+            fwrite(names, sizeof(FuzzyName), name_count, out);
+            for (long i = 0; i < count; i++) {
+                int64_t position = records[i].position;
+                fwrite(&position, sizeof(position), 1, out);
+            }
+            for (uint64_t n = 0; n < name_count; n++) {
+                fwrite(records[names[n].first_position].name, 1, names[n].length + 1, out);
+            }
+            
+            if (fclose(out) != 0) {
+                printf("Error escribiendo índice aproximado\n");
+            } else {
+                printf("\n=== ÍNDICE APROXIMADO (%s) ===\n", fuzzy_filename);
+                printf("Nombres distintos: %llu | Borrados: %llu (prefijo %d, hasta %d ediciones)\n",
+                       (unsigned long long)name_count, (unsigned long long)pair_count,
+                       FUZZY_PREFIX, FUZZY_MAX_EDITS);
+            }
+        }
+    } else {
+        printf("Error: memoria insuficiente para el índice aproximado\n");
+    }
+    
+    for (long i = 0; i < count; i++) {
+        free(records[i].name);
+    }
+    free(records);
+    free(names);
+    free(pairs);
+}
+
+// Hash de 64 bits (FNV-1a) del identificador, sin normalizar
+uint64_t id_hash64(const char *id) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    while (*id) {
+        hash ^= (unsigned char)*id++;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Vector de características de una canción (la duración en escala logarítmica)
+void song_features(const SongRecord *song, float *features) {
+    features[0] = (float)song->danceability;
+    features[1] = (float)song->energy;
+    features[2] = (float)song->tempo;
+    features[3] = logf(song->duration_ms > 1000 ? (float)song->duration_ms : 1000.0f);
+}
+
+int compare_vec_ids(const void *a, const void *b) {
+    const VecIdEntry *ea = a, *eb = b;
+    if (ea->hash != eb->hash) return ea->hash < eb->hash ? -1 : 1;
+    return ea->row < eb->row ? -1 : (ea->row > eb->row);
+}
+
+// Construir el índice de vectores: cada característica se normaliza a
+// [0, 255] con el mínimo y máximo del catálogo y se guarda en un byte
+void build_vector_index(const char *bin_filename, const char *vec_filename) {
+    FILE *file = fopen(bin_filename, "rb");
+    if (!file) {
+        printf("Error abriendo archivo\n");
+        return;
+    }
+    
+    long record_count = count_records(file);
+    float *features = malloc(sizeof(float) * VEC_DIMS * (record_count + 1));
+    VecIdEntry *ids = malloc(sizeof(VecIdEntry) * (record_count + 1));
+    uint8_t *codes = malloc((size_t)VEC_DIMS * (record_count + 1));
+    if (!features || !ids || !codes) {
+        printf("Error: memoria insuficiente para el índice de vectores\n");
+        free(features);
+        free(ids);
+        free(codes);
+        fclose(file);
+        return;
+    }
+    
+    VecHeader header;
+    memset(&header, 0, sizeof(header));
+    float max[VEC_DIMS];
+    
+    fseek(file, sizeof(HashEntry) * HASH_SIZE, SEEK_SET);
+    SongRecord song;
+    long count = 0;
+    while (count < record_count && fread(&song, sizeof(SongRecord), 1, file) == 1) {
+        float *f = &features[count * VEC_DIMS];
+        song_features(&song, f);
+        for (int d = 0; d < VEC_DIMS; d++) {
+            if (count == 0 || f[d] < header.min[d]) header.min[d] = f[d];
+            if (count == 0 || f[d] > max[d]) max[d] = f[d];
+        }
+        ids[count].hash = id_hash64(song.id);
+        ids[count].row = (uint64_t)count;
+        count++;
+    }
+    fclose(file);
+    
+    for (int d = 0; d < VEC_DIMS && count > 0; d++) {
+        header.scale[d] = max[d] > header.min[d] ? 255.0f / (max[d] - header.min[d]) : 0.0f;
+    }
+    for (long i = 0; i < count * VEC_DIMS; i++) {
+        int d = (int)(i % VEC_DIMS);
+        float q = (features[i] - header.min[d]) * header.scale[d] + 0.5f;
+        codes[i] = (uint8_t)(q < 0.0f ? 0 : (q > 255.0f ? 255 : q));
+    }
+    qsort(ids, count, sizeof(VecIdEntry), compare_vec_ids);
+    
+    header.magic = VEC_MAGIC;
+    header.dims = VEC_DIMS;
+    header.record_count = (uint64_t)count;
+    
+    FILE *out = fopen(vec_filename, "wb");
+    if (!out) {
+        printf("Error creando archivo %s\n", vec_filename);
+    } else {
+        fwrite(&header, sizeof(header), 1, out);
+        fwrite(ids, sizeof(VecIdEntry), count, out);
+        fwrite(codes, VEC_DIMS, count, out);
+        if (fclose(out) != 0) {
+            printf("Error escribiendo índice de vectores\n");
+        } else {
+            printf("\nÍndice de vectores: %s (%ld canciones, %d bytes por canción)\n",
+                   vec_filename, count, VEC_DIMS);
+        }
+    }
+    
+    free(features);
+    free(ids);
+    free(codes);
+}
+
+int compare_complete_terms(const void *a, const void *b) {
+    const CompleteTerm *ta = a, *tb = b;
+    int cmp = strcmp(ta->key, tb->key);
+    if (cmp != 0) return cmp;
+    if (ta->kind != tb->kind) return ta->kind - tb->kind;
+    return strcmp(ta->text, tb->text);
+}
+
+int compare_complete_hot(const void *a, const void *b) {
+    return strcmp(((const CompleteHot*)a)->prefix, ((const CompleteHot*)b)->prefix);
+}
+
+// Agregar un término (nombre o artista) a la lista de construcción
+int complete_add_term(CompleteTermList *list, const char *text, size_t length,
+                      int kind, int year) {
+    while (length > 0 && isspace((unsigned char)*text)) {
+        text++;
+        length--;
+    }
+    while (length > 0 && isspace((unsigned char)text[length - 1])) length--;
+    if (length == 0 || length > UINT16_MAX) return 1;
+    
+    if (list->count == list->capacity) {
+        long capacity = list->capacity ? list->capacity * 2 : 1024;
+        CompleteTerm *items = realloc(list->items, sizeof(CompleteTerm) * capacity);
+        if (!items) return 0;
+        list->items = items;
+        list->capacity = capacity;
+    }
+    
+    CompleteTerm *term = &list->items[list->count];
+    term->text = strndup(text, length);
+    term->key = strndup(text, length);
+    if (!term->text || !term->key) {
+        free(term->text);
+        free(term->key);
+        return 0;
+    }
+    for (size_t i = 0; i < length; i++) {
+        term->key[i] = tolower((unsigned char)term->key[i]);
+    }
+    term->kind = kind;
+    term->year = year;
+    list->count++;
+    return 1;
+}
+
+// Separar la lista de artistas ("['A', \"B's\"]") en nombres individuales
+int complete_add_artists(CompleteTermList *list, const char *artists, int year) {
+    const char *p = artists;
+    while (isspace((unsigned char)*p)) p++;
+    if (*p != '[') {
+        return complete_add_term(list, p, strlen(p), COMPLETE_KIND_ARTIST, year);
+    }
+    
+    p++;
+    while (*p && *p != ']') {
+        if (*p != '\'' && *p != '"') {
+            p++;
+            continue;
+        }
+        
+        // El nombre termina en la comilla que precede a ',' o ']'
+        char quote = *p++;
+        const char *start = p;
+        while (*p && !(*p == quote && (p[1] == ',' || p[1] == ']' || p[1] == '\0'))) p++;
+        if (!complete_add_term(list, start, p - start, COMPLETE_KIND_ARTIST, year)) {
+            return 0;
+        }
+        if (*p) p++;
+    }
+    return 1;
+}
+
+// Orden de sugerencias: más canciones, luego más reciente, luego alfabético
+int complete_better(const CompleteEntry *entries, uint32_t a, uint32_t b) {
+    if (entries[a].count != entries[b].count) return entries[a].count > entries[b].count;
+    if (entries[a].year != entries[b].year) return entries[a].year > entries[b].year;
+    return a < b;
+}
+
+// Construir el índice de autocompletado sobre nombres de canciones y
+// artistas; los prefijos cortos con muchos términos guardan sus mejores
+// sugerencias para no recorrer el rango en cada tecla
+void build_complete_index(const char *bin_filename, const char *complete_filename,
+                          const TextDictionary *artists) {
+    FILE *file = fopen(bin_filename, "rb");
+    if (!file) {
+        printf("Error abriendo archivo\n");
+        return;
+    }
+    
+    long record_count = count_records(file);
+    CompleteTermList list = {NULL, 0, 0};
+    
+    fseek(file, sizeof(HashEntry) * HASH_SIZE, SEEK_SET);
+    SongRecord song;
+    long records = 0;
+    int ok = 1;
+    while (ok && records < record_count && fread(&song, sizeof(SongRecord), 1, file) == 1) {
+        ok = complete_add_term(&list, song.name, strlen(song.name), COMPLETE_KIND_NAME, song.year) &&
+             (song.artist_id >= artists->text_count ||
+              complete_add_artists(&list, artists->texts[song.artist_id], song.year));
+        records++;
+    }
+    fclose(file);
+    
+    CompleteTerm *terms = list.items;
+    long term_count = list.count;
+    
+    CompleteEntry *entries = NULL;
+    CompleteHot *hot = NULL;
+    uint64_t entry_count = 0;
+    uint64_t hot_count = 0;
+    uint64_t heap_size = 0;
+    
+    if (ok) {
+        qsort(terms, term_count, sizeof(CompleteTerm), compare_complete_terms);
+        entries = malloc(sizeof(CompleteEntry) * (term_count + 1));
+        ok = entries != NULL;
+    }
+    
+    if (ok) {
+        // Términos distintos por (minúsculas, tipo); se muestra la primera forma
+        long *first_term = malloc(sizeof(long) * (term_count + 1));
+        ok = first_term != NULL;
+        for (long i = 0; ok && i < term_count; i++) {
+            if (i > 0 && strcmp(terms[i].key, terms[i - 1].key) == 0 &&
+                terms[i].kind == terms[i - 1].kind) {
+                CompleteEntry *entry = &entries[entry_count - 1];
+                entry->count++;
+                if (terms[i].year > entry->year) entry->year = terms[i].year;
+                continue;
+            }
+            
+            CompleteEntry *entry = &entries[entry_count];
+            entry->text_offset = (uint32_t)heap_size;
+            entry->length = (uint16_t)strlen(terms[i].text);
+            entry->kind = (uint8_t)terms[i].kind;
+            entry->reserved = 0;
+            entry->count = 1;
+            entry->year = terms[i].year;
+            first_term[entry_count++] = i;
+            heap_size += entry->length + 1;
+        }
+        
+        // Prefijos de 1 a COMPLETE_HOT_PREFIX bytes con rangos grandes; cada
+        // longitud aporta a lo sumo entry_count / COMPLETE_HOT_MIN prefijos
+        hot = malloc(sizeof(CompleteHot) * (entry_count / COMPLETE_HOT_MIN + 1) * COMPLETE_HOT_PREFIX);
+        ok = ok && hot;
+        for (int length = 1; ok && length <= COMPLETE_HOT_PREFIX; length++) {
+            uint64_t i = 0;
+            while (i < entry_count) {
+                const char *key = terms[first_term[i]].key;
+                if (entries[i].length < length) {
+                    i++;
+                    continue;
+                }
+                
+                uint64_t j = i + 1;
+                while (j < entry_count && entries[j].length >= length &&
+                       memcmp(terms[first_term[j]].key, key, length) == 0) j++;
+                
+                if (j - i > COMPLETE_HOT_MIN) {
+                    CompleteHot *h = &hot[hot_count++];
+                    memset(h->prefix, 0, sizeof(h->prefix));
+                    memcpy(h->prefix, key, length);
+                    
+                    // Selección por inserción de los COMPLETE_TOP mejores
+                    int filled = 0;
+                    for (uint64_t k = i; k < j; k++) {
+                        if (filled == COMPLETE_TOP &&
+                            !complete_better(entries, (uint32_t)k, h->top[filled - 1])) continue;
+                        int pos = filled < COMPLETE_TOP ? filled++ : COMPLETE_TOP - 1;
+                        while (pos > 0 && complete_better(entries, (uint32_t)k, h->top[pos - 1])) {
+                            h->top[pos] = h->top[pos - 1];
+                            pos--;
+                        }
+                        h->top[pos] = (uint32_t)k;
+                    }
+                    for (int k = filled; k < COMPLETE_TOP; k++) h->top[k] = UINT32_MAX;
+                }
+                i = j;
+            }
+        }
+        qsort(hot, hot_count, sizeof(CompleteHot), compare_complete_hot);
+        
+        FILE *out = ok ? fopen(complete_filename, "wb") : NULL;
+        if (ok && !out) {
+            printf("Error creando archivo %s\n", complete_filename);
+        } else if (out) {
+            CompleteHeader header = {COMPLETE_MAGIC, COMPLETE_TOP, (uint64_t)records,
+                                     entry_count, hot_count, heap_size};
+            fwrite(&header, sizeof(header), 1, out);
+            fwrite(entries, sizeof(CompleteEntry), entry_count, out);
+            fwrite(hot, sizeof(CompleteHot), hot_count, out);
+            for (uint64_t n = 0; n < entry_count; n++) {
+                fwrite(terms[first_term[n]].text, 1, entries[n].length + 1, out);
+            }
+            
+            if (fclose(out) != 0) {
+                printf("Error escribiendo índice de autocompletado\n");
+            } else {
+                printf("\n=== ÍNDICE DE AUTOCOMPLETADO (%s) ===\n", complete_filename);
+                printf("Términos distintos: %llu | Prefijos precalculados: %llu\n",
+                       (unsigned long long)entry_count, (unsigned long long)hot_count);
+            }
+        }
+        free(first_term);
+    }
+    
+    if (!ok) {
+        printf("Error: memoria insuficiente para el índice de autocompletado\n");
+    }
+    
+    for (long i = 0; i < term_count; i++) {
+        free(terms[i].key);
+        free(terms[i].text);
+    }
+    free(terms);
+    free(entries);
+    free(hot);
+}
+
+// Compresor de bloque en formato LZ4 (voraz, una tabla hash de 4 bytes).
+// Devuelve el tamaño comprimido o 0 si no cabe en dst
+int lz4_compress_block(const uint8_t *src, int size, uint8_t *dst, int capacity) {
+    uint32_t table[1 << LZ4_HASH_BITS];
+    memset(table, 0, sizeof(table));
+    int ip = 0, anchor = 0, op = 0;
+    
+    while (ip + LZ4_MATCH_LIMIT < size) {
+        uint32_t sequence;
+        memcpy(&sequence, src + ip, 4);
+        uint32_t h = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+        int ref = (int)table[h] - 1;
+        table[h] = (uint32_t)ip + 1;
+        
+        uint32_t candidate;
+        if (ref < 0 || ip - ref > 65535 ||
+            (memcpy(&candidate, src + ref, 4), candidate != sequence)) {
+            ip++;
+            continue;
+        }
+        
+        int match = LZ4_MIN_MATCH;
+        while (ip + match < size - LZ4_LAST_LITERALS && src[ref + match] == src[ip + match]) match++;
+        
+        // Secuencia: token, longitud de literales, literales, offset, longitud de coincidencia
+        int literals = ip - anchor;
+        if (op + 1 + literals / 255 + 1 + literals + 2 + (match - LZ4_MIN_MATCH) / 255 + 1 > capacity) {
+            return 0;
+        }
+        uint8_t *token = &dst[op++];
+        *token = (uint8_t)((literals >= 15 ? 15 : literals) << 4);
+        if (literals >= 15) {
+            int rest = literals - 15;
+            for (; rest >= 255; rest -= 255) dst[op++] = 255;
+            dst[op++] = (uint8_t)rest;
+        }
+        memcpy(dst + op, src + anchor, literals);
+        op += literals;
+        dst[op++] = (uint8_t)((ip - ref) & 0xFF);
+        dst[op++] = (uint8_t)((ip - ref) >> 8);
+        
+        int extra = match - LZ4_MIN_MATCH;
+        *token |= (uint8_t)(extra >= 15 ? 15 : extra);
+        if (extra >= 15) {
+            int rest = extra - 15;
+            for (; rest >= 255; rest -= 255) dst[op++] = 255;
+            dst[op++] = (uint8_t)rest;
+        }
+        
+        ip += match;
+        anchor = ip;
+    }
+    
+    // Últimos literales
+    int literals = size - anchor;
+    if (op + 1 + literals / 255 + 1 + literals > capacity) return 0;
+    dst[op++] = (uint8_t)((literals >= 15 ? 15 : literals) << 4);
+    if (literals >= 15) {
+        int rest = literals - 15;
+        for (; rest >= 255; rest -= 255) dst[op++] = 255;
+        dst[op++] = (uint8_t)rest;
+    }
+    memcpy(dst + op, src + anchor, literals);
+    return op + literals;
+}
+
+// Cerrar el bloque de texto en curso y agregarlo al heap
+int column_flush_block(const uint8_t *raw, uint32_t raw_size, int compress, uint8_t **heap,
+                       uint64_t *heap_size, uint64_t *heap_capacity, ColumnBlock *block) {
+    if (*heap_size + COL_BLOCK_SIZE > *heap_capacity) {
+        uint64_t capacity = *heap_capacity ? *heap_capacity * 2 : 4 * COL_BLOCK_SIZE;
+        uint8_t *grown = realloc(*heap, capacity);
+        if (!grown) return 0;
+        *heap = grown;
+        *heap_capacity = capacity;
+    }
+    
+    // Si la compresión no reduce el bloque se guarda tal cual
+    int stored = compress ? lz4_compress_block(raw, (int)raw_size, *heap + *heap_size,
+                                               (int)raw_size - 1) : 0;
+    if (stored <= 0) {
+        memcpy(*heap + *heap_size, raw, raw_size);
+        stored = (int)raw_size;
+    }
+    
+    block->offset = *heap_size;
+    block->stored_size = (uint32_t)stored;
+    block->raw_size = raw_size;
+    *heap_size += stored;
+    return 1;
+}
+
+// Agregar los textos de un diccionario a los bloques; ningún texto
+// queda partido entre dos bloques
+int column_add_strings(char **dict, uint32_t count, ColumnString *strings, uint8_t *raw,
+                       uint32_t *raw_size, int compress, uint8_t **heap, uint64_t *heap_size,
+                       uint64_t *heap_capacity, ColumnBlock *blocks, uint64_t *block_count) {
+    for (uint32_t i = 0; i < count; i++) {
+        size_t length = strlen(dict[i]);
+        if (*raw_size + length > COL_BLOCK_SIZE) {
+            if (!column_flush_block(raw, *raw_size, compress, heap, heap_size, heap_capacity,
+                                    &blocks[*block_count])) return 0;
+            (*block_count)++;
+            *raw_size = 0;
+        }
+        
+        strings[i].offset = *raw_size;
+        strings[i].length = (uint16_t)length;
+        strings[i].block = (uint16_t)*block_count;
+        memcpy(raw + *raw_size, dict[i], length);
+        *raw_size += (uint32_t)length;
+    }
+    return 1;
+}
+
+// Construir el archivo de columnas: los diccionarios de artistas y álbum
+// (texto opcionalmente comprimido por bloques), que la búsqueda necesita
+// para leer los registros, y los identificadores y campos numéricos
+// empaquetados en el orden de filas de la base
+void build_column_store(const char *bin_filename, const char *col_filename, int compress,
+                        const TextDictionary *artists, const TextDictionary *albums) {
+    FILE *file = fopen(bin_filename, "rb");
+    if (!file) {
+        printf("Error abriendo archivo\n");
+        return;
+    }
+    
+    long record_count = count_records(file);
+    size_t n = (size_t)record_count + 1;
+    uint32_t artist_count = artists->text_count, album_count = albums->text_count;
+    uint32_t *artist_ids = malloc(sizeof(uint32_t) * n);
+    uint32_t *album_ids = malloc(sizeof(uint32_t) * n);
+    int32_t *durations = malloc(sizeof(int32_t) * n);
+    float *danceability = malloc(sizeof(float) * n);
+    float *energy = malloc(sizeof(float) * n);
+    float *tempo = malloc(sizeof(float) * n);
+    int16_t *years = malloc(sizeof(int16_t) * n);
+    ColumnString *strings = malloc(sizeof(ColumnString) * ((size_t)artist_count + album_count + 1));
+    ColumnBlock *blocks = malloc(sizeof(ColumnBlock) * ((size_t)artist_count + album_count + 1));
+    uint8_t *raw = malloc(COL_BLOCK_SIZE);
+    uint8_t *heap = NULL;
+    uint64_t heap_size = 0, heap_capacity = 0, block_count = 0;
+    uint32_t raw_size = 0;
+    long count = 0;
+    int ok = artist_ids && album_ids && durations && danceability && energy && tempo &&
+             years && strings && blocks && raw;
+    if (!ok) printf("Error: memoria insuficiente para el archivo de columnas\n");
+    
+    fseek(file, sizeof(HashEntry) * HASH_SIZE, SEEK_SET);
+    SongRecord song;
+    while (ok && count < record_count && fread(&song, sizeof(SongRecord), 1, file) == 1) {
+        if (song.artist_id >= artist_count || song.album_id >= album_count) {
+            printf("Error: identificador de texto fuera del diccionario en la fila %ld\n", count);
+            ok = 0;
+            break;
+        }
+        artist_ids[count] = song.artist_id;
+        album_ids[count] = song.album_id;
+        durations[count] = song.duration_ms;
+        danceability[count] = (float)song.danceability;
+        energy[count] = (float)song.energy;
+        tempo[count] = (float)song.tempo;
+        years[count] = (int16_t)song.year;
+        count++;
+    }
+    fclose(file);
+    
+    if (ok) {
+        ok = column_add_strings(artists->texts, artist_count, strings, raw, &raw_size, compress,
+                                &heap, &heap_size, &heap_capacity, blocks, &block_count) &&
+             column_add_strings(albums->texts, album_count, strings + artist_count, raw, &raw_size,
+                                compress, &heap, &heap_size, &heap_capacity, blocks, &block_count);
+        if (ok && raw_size > 0) {
+            ok = column_flush_block(raw, raw_size, compress, &heap, &heap_size, &heap_capacity,
+                                    &blocks[block_count]);
+            block_count++;
+        }
+        if (ok && block_count > UINT16_MAX) {
+            printf("Error: demasiado texto para el archivo de columnas\n");
+            ok = 0;
+        }
+    }
+    
+    if (ok) {
+        FILE *out = fopen(col_filename, "wb");
+        if (!out) {
+            printf("Error creando archivo %s\n", col_filename);
+        } else {
+            ColumnHeader header = {COL_MAGIC, compress ? COL_COMPRESSED : 0, (uint64_t)count,
+                                   artist_count, album_count, block_count, heap_size};
+            fwrite(&header, sizeof(header), 1, out);
+            fwrite(strings, sizeof(ColumnString), artist_count + album_count, out);
+            fwrite(blocks, sizeof(ColumnBlock), block_count, out);
+            fwrite(artist_ids, sizeof(uint32_t), count, out);
+            fwrite(album_ids, sizeof(uint32_t), count, out);
+            fwrite(durations, sizeof(int32_t), count, out);
+            fwrite(danceability, sizeof(float), count, out);
+            fwrite(energy, sizeof(float), count, out);
+            fwrite(tempo, sizeof(float), count, out);
+            fwrite(years, sizeof(int16_t), count, out);
+            fwrite(heap, 1, heap_size, out);
+            
+            long file_size = ftell(out);
+            if (fclose(out) != 0) {
+                printf("Error escribiendo archivo de columnas\n");
+            } else {
+                printf("\n=== ARCHIVO DE COLUMNAS (%s) ===\n", col_filename);
+                printf("Artistas distintos: %u | Álbumes distintos: %u\n", artist_count, album_count);
+                printf("Bloques de texto: %llu (%s, %llu bytes)\n", (unsigned long long)block_count,
+                       compress ? "LZ4" : "sin comprimir", (unsigned long long)heap_size);
+                printf("Tamaño: %ld bytes (%.1f bytes por canción); registro de %zu bytes en lugar de %zu\n",
+                       file_size, count > 0 ? (double)file_size / count : 0.0, sizeof(SongRecord),
+                       sizeof(SongRecord) - 2 * sizeof(uint32_t) + MAX_ALBUM + MAX_ARTIST);
+            }
+        }
+    }
+    
+    free(artist_ids);
+    free(album_ids);
+    free(durations);
+    free(danceability);
+    free(energy);
+    free(tempo);
+    free(years);
+    free(strings);
+    free(blocks);
+    free(raw);
+    free(heap);
+}
+
+// Construir el hash perfecto mínimo (hash-and-displace, estilo CHD) sobre
+// los nombres normalizados: una búsqueda exacta queda en una lectura de
+// ranura más una lectura de registro
+void build_name_mph(const char *bin_filename, const char *mph_filename) {
+    FILE *file = fopen(bin_filename, "rb");
+    if (!file) {
+        printf("Error abriendo archivo\n");
+        return;
+    }
+    
+    long record_count = count_records(file);
+    HashEntry hash_table[HASH_SIZE];
+    KeyPosition *entries = malloc(sizeof(KeyPosition) * (record_count + 1));
+    long *next_positions = malloc(sizeof(long) * (record_count + 1));
+    if (!entries || !next_positions) {
+        printf("Error: memoria insuficiente para el índice MPH\n");
+        free(entries);
+        free(next_positions);
+        fclose(file);
+        return;
+    }
+    fseek(file, 0, SEEK_SET);
+    if (fread(hash_table, sizeof(HashEntry), HASH_SIZE, file) != HASH_SIZE) {
+        printf("Error leyendo tabla hash\n");
+        free(entries);
+        free(next_positions);
+        fclose(file);
+        return;
+    }
+    
+    // Recorrido secuencial: los registros tienen tamaño fijo tras la tabla hash
+    long base = (long)(sizeof(HashEntry) * HASH_SIZE);
+    long count = 0;
+    SongRecord song;
+    while (count < record_count && fread(&song, sizeof(SongRecord), 1, file) == 1) {
+        entries[count].hash = name_hash64(song.name);
+        entries[count].position = base + count * (long)sizeof(SongRecord);
+        entries[count].rank = record_count + count; // Fuera de toda cadena: al final
+        next_positions[count] = song.next;
+        count++;
+    }
+    fclose(file);
+    
+    // Las listas de duplicados siguen el orden de la cadena (el mismo que
+    // devuelve el recorrido: más reciente primero, o el orden de -c)
+    long rank = 0;
+    for (int b = 0; b < HASH_SIZE; b++) {
+        long position = hash_table[b].first_position;
+        for (long steps = 0; position != -1 && steps < count; steps++) {
+            long row = (position - base) / (long)sizeof(SongRecord);
+            if (position < base || row >= count) break;
+            entries[row].rank = rank++;
+            position = next_positions[row];
+        }
+    }
+    free(next_positions);
+    
+    qsort(entries, count, sizeof(KeyPosition), compare_key_positions);
+    
+    // Agrupar nombres repetidos: cada clave distinta es una ranura
+    uint64_t key_count = 0;
+    long *key_first = malloc(sizeof(long) * (count + 1));
+    uint32_t *key_size = malloc(sizeof(uint32_t) * (count + 1));
+    if (!key_first || !key_size) {
+        printf("Error: memoria insuficiente para el índice MPH\n");
+        free(entries);
+        free(key_first);
+        free(key_size);
+        return;
+    }
+    for (long i = 0; i < count; i++) {
+        if (i == 0 || entries[i].hash != entries[i - 1].hash) {
+            key_first[key_count] = i;
+            key_size[key_count] = 0;
+            key_count++;
+        }
+        key_size[key_count - 1]++;
+    }
+    
+    uint64_t bucket_count = key_count / MPH_KEYS_PER_BUCKET + 1;
+    uint32_t *bucket_start = calloc(bucket_count + 1, sizeof(uint32_t));
+    uint32_t *bucket_keys = malloc(sizeof(uint32_t) * (key_count + 1));
+    uint32_t *fill = malloc(sizeof(uint32_t) * bucket_count);
+    uint32_t *order = malloc(sizeof(uint32_t) * bucket_count);
+    MphDisplacement *disp = calloc(bucket_count, sizeof(MphDisplacement));
+    uint32_t *slot_key = malloc(sizeof(uint32_t) * (key_count + 1));
+    char *used = calloc(key_count + 1, 1);
+    uint64_t *tmp_slots = NULL;
+    uint64_t ordered = 0;
+    bool ok = bucket_start && bucket_keys && fill && order && disp && slot_key && used;
+    
+    if (ok) {
+        // Ordenar claves por bucket (ordenamiento por conteo)
+        for (uint64_t k = 0; k < key_count; k++) {
+            bucket_start[mix64(entries[key_first[k]].hash) % bucket_count + 1]++;
+        }
+        for (uint64_t b = 0; b < bucket_count; b++) {
+            bucket_start[b + 1] += bucket_start[b];
+        }
+        memcpy(fill, bucket_start, sizeof(uint32_t) * bucket_count);
+        for (uint64_t k = 0; k < key_count; k++) {
+            bucket_keys[fill[mix64(entries[key_first[k]].hash) % bucket_count]++] = (uint32_t)k;
+        }
+        
+        // Procesar buckets de mayor a menor tamaño
+        uint32_t max_size = 0;
+        for (uint64_t b = 0; b < bucket_count; b++) {
+            uint32_t size = bucket_start[b + 1] - bucket_start[b];
+            if (size > max_size) max_size = size;
+        }
+        for (uint32_t size = max_size; size > 0; size--) {
+            for (uint64_t b = 0; b < bucket_count; b++) {
+                if (bucket_start[b + 1] - bucket_start[b] == size) order[ordered++] = (uint32_t)b;
+            }
+        }
+        
+        tmp_slots = malloc(sizeof(uint64_t) * (max_size + 1));
+        ok = tmp_slots != NULL;
+    }
+    
+    uint64_t free_cursor = 0;
+    if (!ok) {
+        printf("Error: memoria insuficiente para el índice MPH\n");
+    }
+    
+    for (uint64_t o = 0; ok && o < ordered; o++) {
+        uint32_t b = order[o];
+        uint32_t first = bucket_start[b];
+        uint32_t size = bucket_start[b + 1] - first;
+        
+        if (size == 1) {
+            // Clave única: d1 la lleva directamente a la siguiente ranura libre
+            while (used[free_cursor]) free_cursor++;
+            uint32_t k = bucket_keys[first];
+            MphDisplacement zero = {0, 0};
+            uint64_t base = mph_slot(entries[key_first[k]].hash, &zero, key_count);
+            disp[b].d0 = 0;
+            disp[b].d1 = (uint32_t)((free_cursor + key_count - base) % key_count);
+            used[free_cursor] = 1;
+            slot_key[free_cursor] = k;
+            continue;
+        }
+        
+        bool placed = false;
+        for (uint64_t attempt = 0; !placed && attempt < key_count * 64; attempt++) {
+            MphDisplacement d = {(uint32_t)(attempt / key_count), (uint32_t)(attempt % key_count)};
+            uint32_t i;
+            for (i = 0; i < size; i++) {
+                uint64_t slot = mph_slot(entries[key_first[bucket_keys[first + i]]].hash, &d, key_count);
+                if (used[slot]) break;
+                uint32_t j;
+                for (j = 0; j < i && tmp_slots[j] != slot; j++);
+                if (j < i) break;
+                tmp_slots[i] = slot;
+            }
+            if (i == size) {
+                disp[b] = d;
+                for (i = 0; i < size; i++) {
+                    used[tmp_slots[i]] = 1;
+                    slot_key[tmp_slots[i]] = bucket_keys[first + i];
+                }
+                placed = true;
+            }
+        }
+        if (!placed) {
+            printf("Error: no se encontró desplazamiento para el bucket %u\n", b);
+            ok = false;
+        }
+    }
+    
+    FILE *out = ok ? fopen(mph_filename, "wb") : NULL;
+    if (out) {
+        MphHeader header = {MPH_MAGIC, 1, (uint64_t)record_count, key_count, bucket_count, 0};
+        for (uint64_t k = 0; k < key_count; k++) {
+            if (key_size[k] > 1) header.group_count += key_size[k];
+        }
+        
+        long slots_offset = sizeof(MphHeader) + sizeof(MphDisplacement) * bucket_count;
+        long group_offset = slots_offset + (long)(sizeof(MphSlot) * key_count);
+        
+        fwrite(&header, sizeof(header), 1, out);
+        fwrite(disp, sizeof(MphDisplacement), bucket_count, out);
+        
+        for (uint64_t s = 0; s < key_count; s++) {
+            uint32_t k = slot_key[s];
+            MphSlot slot;
+            slot.fingerprint = (uint32_t)(entries[key_first[k]].hash >> 32);
+            slot.count = key_size[k];
+            if (key_size[k] == 1) {
+                slot.position = entries[key_first[k]].position;
+            } else {
+                slot.position = group_offset;
+                group_offset += sizeof(int64_t) * key_size[k];
+            }
+            fwrite(&slot, sizeof(slot), 1, out);
+        }
+        
+        // Listas de duplicados, en el mismo orden de ranuras
+        for (uint64_t s = 0; s < key_count; s++) {
+            uint32_t k = slot_key[s];
+            if (key_size[k] == 1) continue;
+            for (uint32_t i = 0; i < key_size[k]; i++) {
+                int64_t position = entries[key_first[k] + i].position;
+                fwrite(&position, sizeof(position), 1, out);
+            }
+        }
+        
+        if (fclose(out) != 0) {
+            printf("Error escribiendo índice MPH\n");
+        } else {
+            printf("\n=== HASH PERFECTO MÍNIMO (%s) ===\n", mph_filename);
+            printf("Nombres distintos: %llu\n", (unsigned long long)key_count);
+            printf("Buckets: %llu\n", (unsigned long long)bucket_count);
+            printf("Posiciones agrupadas por nombre repetido: %llu\n",
+                   (unsigned long long)header.group_count);
+            printf("Bits por clave (desplazamientos): %.2f\n",
+                   key_count ? (bucket_count * sizeof(MphDisplacement) * 8.0) / key_count : 0.0);
+        }
+    } else if (ok) {
+        printf("Error creando archivo %s\n", mph_filename);
+    }
+    
+    free(entries);
+    free(key_first);
+    free(key_size);
+    free(bucket_start);
+    free(bucket_keys);
+    free(fill);
+    free(order);
+    free(disp);
+    free(slot_key);
+    free(used);
+    free(tmp_slots);
+}
+
+// Marcar un nombre en el filtro: todos sus bits caen en un único bloque
+void bloom_add(uint64_t *blocks, uint64_t block_count, uint64_t hash) {
+    uint64_t *block = blocks + (mix64(hash) % block_count) * BLOOM_BLOCK_WORDS;
+    uint64_t bits = mix64(hash ^ 0x5851f42d4c957f2dull);
+    
+    for (int i = 0; i < BLOOM_HASHES; i++) {
+        unsigned bit = (bits >> (9 * i)) & 511;
+        block[bit >> 6] |= 1ull << (bit & 63);
+    }
+}
+
+// Construir el filtro de Bloom que descarta nombres inexistentes sin
+// tocar el archivo de registros
+void build_name_bloom(const char *bin_filename, const char *bloom_filename) {
+    FILE *file = fopen(bin_filename, "rb");
+    if (!file) {
+        printf("Error abriendo archivo\n");
+        return;
+    }
+    
+    long record_count = count_records(file);
+    uint64_t block_count = ((uint64_t)record_count * BLOOM_BITS_PER_KEY + 511) / 512 + 1;
+    uint64_t *blocks = calloc(block_count * BLOOM_BLOCK_WORDS, sizeof(uint64_t));
+    if (!blocks) {
+        printf("Error: memoria insuficiente para el filtro de Bloom\n");
+        fclose(file);
+        return;
+    }
+    
+    fseek(file, sizeof(HashEntry) * HASH_SIZE, SEEK_SET);
+    SongRecord song;
+    long count = 0;
+    while (count < record_count && fread(&song, sizeof(SongRecord), 1, file) == 1) {
+        bloom_add(blocks, block_count, name_hash64(song.name));
+        count++;
+    }
+    fclose(file);
+    
+    FILE *out = fopen(bloom_filename, "wb");
+    if (!out) {
+        printf("Error creando archivo %s\n", bloom_filename);
+        free(blocks);
+        return;
+    }
+    
+    BloomHeader header = {BLOOM_MAGIC, BLOOM_HASHES, (uint64_t)record_count, block_count};
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(blocks, sizeof(uint64_t), block_count * BLOOM_BLOCK_WORDS, out);
+    
+    if (fclose(out) != 0) {
+        printf("Error escribiendo filtro de Bloom\n");
+    } else {
+        printf("\n=== FILTRO DE BLOOM (%s) ===\n", bloom_filename);
+        printf("Bloques de 512 bits: %llu (%.1f KB)\n", (unsigned long long)block_count,
+               block_count * 64 / 1024.0);
+        printf("Funciones hash: %d | Bits por nombre: %d\n", BLOOM_HASHES, BLOOM_BITS_PER_KEY);
+    }
+    
+    free(blocks);
 }
 
 // Función para mostrar estadísticas del hash
@@ -280,8 +1838,8 @@ void show_hash_stats(const char *filename) {
                 chain_length++;
                 total_songs++;
                 fseek(file, current_pos, SEEK_SET);
-                Song song;
-                size_t items_read = fread(&song, sizeof(Song), 1, file);
+                SongRecord song;
+                size_t items_read = fread(&song, sizeof(SongRecord), 1, file);
                 if (items_read != 1) {
                     printf("Error leyendo canción en posición %ld\n", current_pos);
                     break;
@@ -314,9 +1872,70 @@ void show_hash_stats(const char *filename) {
     fclose(file);
 }
 
-int main() {
+void usage(const char *prog) {
+    printf("Uso: %s [-c] [-m] [-b] [-s] [-f] [-k] [-a] [-z]\n", prog);
+    printf("  -c  Agrupar los registros de cada bucket de forma contigua (%s)\n",
+           DIR_FILENAME);
+    printf("  -m  Construir hash perfecto mínimo para búsqueda por nombre exacto (%s)\n",
+           MPH_FILENAME);
+    printf("  -b  Construir filtro de Bloom para descartar nombres inexistentes (%s)\n",
+           BLOOM_FILENAME);
+    printf("  -s  Construir índice ordenado por campo numérico para ORDER BY (%s)\n",
+           SORT_FILENAME);
+    printf("  -f  Construir diccionario de borrados para búsqueda aproximada (%s)\n",
+           FUZZY_FILENAME);
+    printf("  -k  Construir vectores cuantizados para buscar canciones similares (%s)\n",
+           VEC_FILENAME);
+    printf("  -a  Construir índice de autocompletado de nombres y artistas (%s)\n",
+           COMPLETE_FILENAME);
+    printf("  -z  Comprimir por bloques (formato LZ4) el texto de los diccionarios de %s\n",
+           COL_FILENAME);
+}
+
+int main(int argc, char *argv[]) {
     const char *bin_filename = "songs_database.bin";
     const char *csv_filename = "tracks_features.csv";
+    bool build_mph = false;
+    bool build_bloom = false;
+    bool cluster = false;
+    bool build_sort = false;
+    bool build_fuzzy = false;
+    bool build_vectors = false;
+    bool build_complete = false;
+    bool compress_columns = false;
+    int opt;
+    
+    while ((opt = getopt(argc, argv, "cmbsfkazh")) != -1) {
+        switch (opt) {
+            case 'c':
+                cluster = true;
+                break;
+            case 'm':
+                build_mph = true;
+                break;
+            case 'b':
+                build_bloom = true;
+                break;
+            case 's':
+                build_sort = true;
+                break;
+            case 'f':
+                build_fuzzy = true;
+                break;
+            case 'k':
+                build_vectors = true;
+                break;
+            case 'a':
+                build_complete = true;
+                break;
+            case 'z':
+                compress_columns = true;
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
     
     printf("=== CREADOR DE BASE DE DATOS DE CANCIONES ===\n");
     
@@ -329,16 +1948,68 @@ int main() {
     }
     fclose(test_csv);
     
+    // Los índices auxiliares de una base anterior dejan de ser válidos
+    remove(MPH_FILENAME);
+    remove(BLOOM_FILENAME);
+    remove(DIR_FILENAME);
+    remove(SORT_FILENAME);
+    remove(FUZZY_FILENAME);
+    remove(VEC_FILENAME);
+    remove(COMPLETE_FILENAME);
+    remove(COL_FILENAME);
+    
     // Crear archivo binario
     create_binary_file(bin_filename);
     
     // Cargar canciones desde CSV
     printf("Cargando canciones desde: %s\n", csv_filename);
-    load_songs_from_csv(csv_filename, bin_filename);
+    TextDictionary artists = {0}, albums = {0};
+    if (!load_songs_from_csv(csv_filename, bin_filename, &artists, &albums)) {
+        printf("Error: no se pudo cargar la base\n");
+        dictionary_free(&artists);
+        dictionary_free(&albums);
+        return 1;
+    }
+    
+    // Agrupar antes de construir índices: cambia las posiciones
+    if (cluster) {
+        cluster_database(bin_filename, DIR_FILENAME);
+    }
+    
+    // Los registros solo guardan identificadores: sin los diccionarios no se
+    // puede leer el álbum ni los artistas
+    build_column_store(bin_filename, COL_FILENAME, compress_columns, &artists, &albums);
     
     // Mostrar estadísticas
     show_hash_stats(bin_filename);
     
+    if (build_mph) {
+        build_name_mph(bin_filename, MPH_FILENAME);
+    }
+    
+    if (build_bloom) {
+        build_name_bloom(bin_filename, BLOOM_FILENAME);
+    }
+    
+    if (build_sort) {
+        build_sort_index(bin_filename, SORT_FILENAME);
+    }
+    
+    if (build_fuzzy) {
+        build_fuzzy_index(bin_filename, FUZZY_FILENAME);
+    }
+    
+    if (build_vectors) {
+        build_vector_index(bin_filename, VEC_FILENAME);
+    }
+    
+    if (build_complete) {
+        build_complete_index(bin_filename, COMPLETE_FILENAME, &artists);
+    }
+    
+    dictionary_free(&artists);
+    dictionary_free(&albums);
+    
     printf("\nBase de datos creada exitosamente en: %s\n", bin_filename);
     
     return 0;
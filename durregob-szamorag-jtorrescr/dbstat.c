@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/shm.h>
+#include <sys/ipc.h>
+
+#include "metrics.h"
+
+// Nombre legible de cada tipo de consulta
+const char *query_type_name(int type) {
+    switch (type) {
+        case 1: return "nombre exacto";
+        case 2: return "palabra";
+        case 3: return "artista";
+        case 4: return "año";
+        case 5: return "estadísticas";
+        case 6: return "aproximada";
+        case 7: return "similares";
+        case 8: return "autocompletar";
+        case 9: return "lote";
+        case 10: return "agregación";
+        default: return "otro";
+    }
+}
+
+// Percentil aproximado a partir del histograma (límite superior del bucket)
+uint64_t latency_percentile(const QueryMetrics *m, double p) {
+    uint64_t total = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        total += m->latency_hist[i];
+    }
+    if (total == 0) return 0;
+
+    uint64_t target = (uint64_t)(total * p);
+    if (target >= total) target = total - 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += m->latency_hist[i];
+        if (seen > target) {
+            return 1ull << (i + 1);
+        }
+    }
+    return 1ull << LATENCY_BUCKETS;
+}
+
+// Mostrar una instantánea de la página de métricas
+void print_snapshot(const MetricsPage *page, int show_histogram) {
+    // Copia local para no leer valores a medio actualizar entre columnas
+    MetricsPage snap;
+    memcpy(&snap, page, sizeof(snap));
+
+    printf("\n=== MÉTRICAS DEL PROCESO DE BÚSQUEDA (PID %d) ===\n", snap.server_pid);
+    printf("Activo desde hace: %lld s\n", (long long)(time(NULL) - snap.start_time));
+    printf("Cola: %llu pendientes (máximo %llu)\n",
+           (unsigned long long)snap.queue_depth, (unsigned long long)snap.max_queue_depth);
+    if (snap.pool_budget > 0) {
+        uint64_t accesses = snap.pool_hits + snap.pool_misses;
+        printf("Buffer pool: %llu KB | aciertos %llu | fallos %llu | desalojos %llu | tasa %.1f%%\n",
+               (unsigned long long)(snap.pool_budget / 1024), (unsigned long long)snap.pool_hits,
+               (unsigned long long)snap.pool_misses, (unsigned long long)snap.pool_evictions,
+               accesses ? 100.0 * snap.pool_hits / accesses : 0.0);
+    }
+    printf("%-14s %8s %9s %11s %12s %9s %7s %8s %8s %8s %8s %9s %9s %9s\n",
+           "tipo", "consultas", "resultados", "registros", "bytes", "cadena",
+           "max_cad", "pool", "bloque", "prefijo", "filtro", "prom_us", "p99_us", "max_us");
+
+    for (int t = 0; t < METRICS_QUERY_TYPES; t++) {
+        const QueryMetrics *m = &snap.by_type[t];
+        if (m->requests == 0) continue;
+
+        printf("%-14s %8llu %9llu %11llu %12llu %9llu %7llu %8llu %8llu %8llu %8llu %9llu %9llu %9llu\n",
+               query_type_name(t),
+               (unsigned long long)m->requests,
+               (unsigned long long)m->results,
+               (unsigned long long)m->records_scanned,
+               (unsigned long long)m->bytes_read,
+               (unsigned long long)m->chain_links,
+               (unsigned long long)m->max_chain,
+               (unsigned long long)m->pool_hits,
+               (unsigned long long)m->block_hits,
+               (unsigned long long)m->prefix_hits,
+               (unsigned long long)m->filter_rejects,
+               (unsigned long long)(m->latency_us_total / m->requests),
+               (unsigned long long)latency_percentile(m, 0.99),
+               (unsigned long long)m->latency_us_max);
+
+        if (show_histogram) {
+            for (int i = 0; i < LATENCY_BUCKETS; i++) {
+                if (m->latency_hist[i] == 0) continue;
+                printf("    [%8llu us, %8llu us): %llu\n",
+                       i == 0 ? 0ull : 1ull << i, 1ull << (i + 1),
+                       (unsigned long long)m->latency_hist[i]);
+            }
+        }
+    }
+}
+
+void usage(const char *prog) {
+    printf("Uso: %s [-i segundos] [-H]\n", prog);
+    printf("  -i N  Repetir cada N segundos\n");
+    printf("  -H    Mostrar histograma de latencias\n");
+}
+
+int main(int argc, char *argv[]) {
+    int interval = 0;
+    int show_histogram = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:Hh")) != -1) {
+        switch (opt) {
+            case 'i':
+                interval = atoi(optarg);
+                break;
+            case 'H':
+                show_histogram = 1;
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    // Solo lectura: dbstat nunca modifica la página del servidor
+    int shm_id = shmget(METRICS_SHM_KEY, 0, 0);
+    if (shm_id == -1) {
+        printf("No hay un proceso de búsqueda publicando métricas\n");
+        return 1;
+    }
+
+    MetricsPage *page = (MetricsPage*)shmat(shm_id, NULL, SHM_RDONLY);
+    if (page == (void*)-1) {
+        perror("Error adjuntando la página de métricas");
+        return 1;
+    }
+
+    if (__atomic_load_n(&page->magic, __ATOMIC_ACQUIRE) != METRICS_MAGIC) {
+        printf("La página de métricas no está inicializada\n");
+        shmdt(page);
+        return 1;
+    }
+    
+    // Otra versión tiene otra disposición: leerla daría columnas corridas
+    if (page->version != METRICS_VERSION) {
+        printf("La página de métricas es de la versión %u (dbstat entiende la %d)\n",
+               page->version, METRICS_VERSION);
+        shmdt(page);
+        return 1;
+    }
+
+    do {
+        print_snapshot(page, show_histogram);
+        fflush(stdout);
+        if (interval > 0) sleep(interval);
+    } while (interval > 0);
+
+    shmdt(page);
+    return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+
+// Página de métricas compartida entre p1-dataProgram (escribe) y dbstat (lee)
+
+#define METRICS_SHM_KEY 0x1235
+#define METRICS_MAGIC 0x4D455452 // "METR"
+#define METRICS_VERSION 4        // Subir con cada cambio de MetricsPage o QueryMetrics
+#define METRICS_QUERY_TYPES 16
+#define LATENCY_BUCKETS 24
+
+// Contadores acumulados de un tipo de consulta
+typedef struct {
+    uint64_t requests;
+    uint64_t results;
+    uint64_t records_scanned;
+    uint64_t bytes_read;
+    uint64_t chain_links;        // Eslabones de cadena hash recorridos
+    uint64_t max_chain;          // Cadena más larga recorrida en una consulta
+    uint64_t pool_hits;          // Páginas servidas desde el buffer pool
+    uint64_t block_hits;         // Bloques de texto de columnas ya descomprimidos
+    uint64_t prefix_hits;        // Prefijos respondidos desde la tabla de autocompletado
+    uint64_t filter_rejects;     // Consultas descartadas por el filtro de Bloom
+    uint64_t latency_us_total;
+    uint64_t latency_us_max;
+    uint64_t latency_hist[LATENCY_BUCKETS]; // Bucket i: [2^i, 2^(i+1)) µs
+} QueryMetrics;
+
+// Página de métricas en memoria compartida (solo lectura para dbstat)
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int32_t server_pid;
+    int64_t start_time;
+    uint64_t queue_depth;        // Solicitudes enviadas aún no atendidas
+    uint64_t max_queue_depth;
+    QueryMetrics by_type[METRICS_QUERY_TYPES];
+    uint64_t pool_budget;        // Bytes del buffer pool (0 = sin pool)
+    uint64_t pool_hits;
+    uint64_t pool_misses;
+    uint64_t pool_evictions;
+} MetricsPage;
+
+#endif
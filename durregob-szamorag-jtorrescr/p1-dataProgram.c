@@ -1,3 +1,4 @@
+#define _GNU_SOURCE // O_DIRECT
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,20 +12,117 @@
 #include <time.h>
 #include <sys/wait.h>
 #include <errno.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <math.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <poll.h>
+#include <pthread.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "metrics.h"
 
 #define HASH_SIZE 1000
 #define MAX_TITLE 256
 #define MAX_ARTIST 256
 #define MAX_ALBUM 256
 #define MAX_RESULTS 100
-#define SHM_KEY 0x1234
-#define SEM_KEY 0x5678
+#define BATCH_MAX 1024
+#define BATCH_SEARCH_TYPE 9
+#define SERVER_MAX_EVENTS 64
+#define SERVER_READ_CHUNK 65536
+#define SERVER_MAX_PENDING_OUTPUT (4 * 1024 * 1024) // Deja de leer hasta vaciar la salida
+#define WIRE_OK 0
+#define WIRE_BAD_REQUEST -1
+#define TRACE_CAPACITY 8192
+#define MPH_FILENAME "songs_name.mph"
+#define MPH_MAGIC 0x3148504D // "MPH1"
+#define BLOOM_FILENAME "songs_name.bloom"
+#define BLOOM_MAGIC 0x314D4C42 // "BLM1"
+#define BLOOM_BLOCK_WORDS 8
+#define BLOOM_MAX_HASHES 7       // 9 bits por función sobre un hash de 64 bits
+#define DIR_FILENAME "songs_database.dir"
+#define DIR_MAGIC 0x31524944 // "DIR1"
+#define SCAN_BATCH 64
+#define SORT_FILENAME "songs_database.sort"
+#define SORT_MAGIC 0x31545253 // "SRT1"
+#define SORT_BATCH 256
+
+// Campos numéricos por los que se puede ordenar (ORDER BY)
+#define ORDER_NONE 0
+#define ORDER_ENERGY 1
+#define ORDER_DANCEABILITY 2
+#define ORDER_TEMPO 3
+#define ORDER_DURATION 4
+#define ORDER_YEAR 5
+#define ORDER_FIELDS 5
+
+#define FUZZY_FILENAME "songs_name.fuzzy"
+#define FUZZY_MAGIC 0x31595A46 // "FZY1"
+#define FUZZY_PREFIX 7
+#define FUZZY_MAX_EDITS 2
+#define FUZZY_MAX_DELETES 32
+#define FUZZY_MAX_CANDIDATES 65536
+
+#define VEC_FILENAME "songs_database.vec"
+#define VEC_MAGIC 0x31434556 // "VEC1"
+#define VEC_DIMS 4
+#define KNN_RERANK 4            // Candidatos por resultado para reordenar con valores exactos
+#define KNN_MAX_CANDIDATES 512
+#define KNN_BLOCK 4096
+
+#define COMPLETE_FILENAME "songs_names.complete"
+#define COMPLETE_MAGIC 0x31504D43 // "CMP1"
+#define COMPLETE_TOP 16
+#define COMPLETE_HOT_PREFIX 3
+#define COMPLETE_KIND_NAME 0
+#define COMPLETE_KIND_ARTIST 1
+
+#define COL_FILENAME "songs_database.col"
+#define COL_MAGIC 0x324C4F43 // "COL2"
+#define COL_BLOCK_SIZE 4096
+#define COL_COMPRESSED 1
+#define LZ4_MIN_MATCH 4
+
+#define POOL_PAGE_SIZE 4096
+#define POOL_DEFAULT_BUDGET (8L * 1024 * 1024)
+#define POOL_MIN_FRAMES 16
+#define POOL_SCAN_FRAMES 16      // Anillo para recorridos completos
+#define POOL_FRAME_BYTES (POOL_PAGE_SIZE + sizeof(PoolFrame) + 2 * sizeof(int)) // Página y metadatos
+#define POOL_MIN_BYTES (POOL_SCAN_FRAMES * POOL_PAGE_SIZE + POOL_MIN_FRAMES * POOL_FRAME_BYTES)
+
+#define AGGREGATE_SEARCH_TYPE 10
+#define AGG_COUNT 1
+#define AGG_SUM 2
+#define AGG_AVG 3
+#define AGG_MIN 4
+#define AGG_MAX 5
+#define AGG_BY_YEAR 1
+#define AGG_BY_DECADE 2
+#define AGG_BY_ARTIST 3
+#define AGG_BY_TOTAL 4
+#define AGG_MAX_YEAR 4096        // Años agrupables: 0..4095
+#define AGG_BLOCK 1024           // Filas por bloque de columnas
+#define AGG_MAX_THREADS 8
+#define AGG_MEMORY_BUDGET (1L * 1024 * 1024) // Tablas de grupos (sale de -m, a lo sumo 1/8)
 
+// Canción en memoria. El álbum y los artistas se copian del diccionario
+// de songs_database.col solo para las canciones que se devuelven
 typedef struct Song {
     char id[64];
     char name[MAX_TITLE];
     char album[MAX_ALBUM];
     char artists[MAX_ARTIST];
+    uint32_t album_id;
+    uint32_t artist_id;
     int year;
     int duration_ms;
     double danceability;
@@ -33,10 +131,97 @@ typedef struct Song {
     long next;
 } Song;
 
+// Registro en disco (ver creador.c): álbum y artistas como identificadores
+typedef struct {
+    char id[64];
+    char name[MAX_TITLE];
+    uint32_t album_id;
+    uint32_t artist_id;
+    int year;
+    int duration_ms;
+    double danceability;
+    double energy;
+    double tempo;
+    long next;
+} SongRecord;
+
 typedef struct HashEntry {
     long first_position;
 } HashEntry;
 
+// Índice de hash perfecto mínimo generado por "creador -m"
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t record_count;
+    uint64_t key_count;
+    uint64_t bucket_count;
+    uint64_t group_count;
+} MphHeader;
+
+typedef struct {
+    uint32_t d0;
+    uint32_t d1;
+} MphDisplacement;
+
+typedef struct {
+    uint32_t fingerprint;
+    uint32_t count;
+    int64_t position;
+} MphSlot;
+
+// Filtro de Bloom por bloques generado por "creador -b"
+typedef struct {
+    uint32_t magic;
+    uint32_t hashes;
+    uint64_t record_count;
+    uint64_t block_count;
+} BloomHeader;
+
+typedef struct {
+    BloomHeader header;
+    uint64_t *blocks;   // Completo en memoria
+} BloomFilter;
+
+// Directorio de la base agrupada por bucket generado por "creador -c"
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t record_count;
+} DirHeader;
+
+// Registros de un bucket: contiguos a partir de offset
+typedef struct {
+    int64_t offset;
+    int64_t count;
+} BucketRun;
+
+typedef struct {
+    int loaded;
+    BucketRun runs[HASH_SIZE];
+} BucketDirectory;
+
+// Recorrido de todos los registros en el orden de las cadenas hash:
+// secuencial por lotes si la base está agrupada, siguiendo "next" si no
+typedef struct {
+    FILE *file;
+    HashEntry hash_table[HASH_SIZE];
+    int bucket;
+    long current_pos;
+    long position;
+    long remaining;
+    Song batch[SCAN_BATCH];
+    int batch_count;
+    int batch_index;
+} SongCursor;
+
+// Índice cargado: desplazamientos en memoria, ranuras leídas bajo demanda
+typedef struct {
+    FILE *file;
+    MphHeader header;
+    MphDisplacement *disp;
+} MphIndex;
+
 // Estructura para memoria compartida
 typedef struct {
     int search_type;
@@ -47,12 +232,376 @@ typedef struct {
     int request_ready;  // 0 = esperando, 1 = solicitud lista
     int response_ready; // 0 = procesando, 1 = respuesta lista
     int shutdown;       // 0 = ejecutando, 1 = terminar
+    uint32_t request_id;  // Identificador de la solicitud (trazas)
+    uint64_t enqueue_ns;  // Instante de envío (CLOCK_MONOTONIC)
+    int order_field;      // ORDER_NONE = orden del recorrido
+    int order_desc;       // 1 = descendente, 0 = ascendente
+    int limit;            // Máximo de resultados (1 - MAX_RESULTS)
+    int batch_shm_id;     // Segmento privado del lote, creado por el cliente
 } SharedData;
 
+// Solicitud tal como la ejecuta el proceso de búsqueda
+typedef struct {
+    int search_type;
+    char search_term[256];
+    int search_year;
+    int order_field;
+    int order_desc;
+    int limit;
+} Query;
+
+// Protocolo binario del servidor (socket Unix, orden de bytes del host).
+// Solicitud: cabecera fija seguida de term_length bytes del término
+typedef struct {
+    uint32_t length;         // Bytes de la trama completa
+    uint32_t request_id;     // Lo elige el cliente; se repite en la respuesta
+    uint8_t search_type;
+    uint8_t order_field;
+    uint8_t order_desc;
+    uint8_t reserved;
+    int32_t search_year;
+    uint16_t limit;
+    uint16_t term_length;
+} WireRequest;
+
+// Respuesta: cabecera fija seguida de song_count canciones codificadas
+typedef struct {
+    uint32_t length;
+    uint32_t request_id;
+    int32_t status;          // WIRE_OK o WIRE_BAD_REQUEST
+    uint32_t result_count;   // Total (en estadísticas, canciones de la base)
+    uint32_t song_count;
+} WireResponse;
+
+// Canción codificada: campos fijos y luego id, nombre, álbum y artistas
+// sin terminador
+typedef struct {
+    int32_t year;
+    int32_t duration_ms;
+    double danceability;
+    double energy;
+    double tempo;
+    uint16_t lengths[4];
+} WireSong;
+
+// Buffer de bytes creciente (entrada y salida de cada conexión)
+typedef struct {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+} ByteBuffer;
+
+// Conexión de un cliente del servidor
+typedef struct {
+    int fd;
+    ByteBuffer in;
+    ByteBuffer out;
+    uint32_t events;         // Interés registrado en epoll
+} Connection;
+
+// Lote de consultas en su propio segmento de memoria compartida; el
+// proceso de búsqueda escribe las coincidencias etiquetadas en output_path
+typedef struct {
+    int count;
+    char output_path[256];   // Vacío = salida estándar
+    Query queries[BATCH_MAX];
+    int result_counts[BATCH_MAX];
+} BatchData;
+
+// Montículo acotado con los K mejores resultados; la raíz es el peor
+typedef struct {
+    int field;
+    int desc;
+    int capacity;
+    int count;
+    Song items[MAX_RESULTS];
+} TopK;
+
+// Índice ordenado por campo numérico generado por "creador -s"
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t record_count;
+    uint64_t field_count;
+} SortHeader;
+
+// Entrada del índice ordenado: ascendente por valor dentro de cada campo
+typedef struct {
+    double value;
+    int32_t year;
+    int32_t reserved;
+    int64_t position;
+} SortEntry;
+
+typedef struct {
+    FILE *file;
+    SortHeader header;
+} SortIndex;
+
+// Diccionario de borrados generado por "creador -f" (mapeado en memoria)
+typedef struct {
+    uint32_t magic;
+    uint32_t prefix_length;
+    uint64_t record_count;
+    uint64_t name_count;
+    uint64_t pair_count;
+    uint64_t position_count;
+    uint64_t heap_size;
+} FuzzyHeader;
+
+typedef struct {
+    uint32_t hash;
+    uint32_t name_id;
+} FuzzyPair;
+
+typedef struct {
+    uint32_t text_offset;
+    uint32_t length;
+    uint32_t count;
+    uint32_t first_position;
+} FuzzyName;
+
+typedef struct {
+    void *map;
+    size_t map_size;
+    const FuzzyHeader *header;
+    const FuzzyPair *pairs;
+    const FuzzyName *names;
+    const int64_t *positions;
+    const char *heap;
+} FuzzyIndex;
+
+// Índice de vectores cuantizados generado por "creador -k" (mapeado en memoria)
+typedef struct {
+    uint32_t magic;
+    uint32_t dims;
+    uint64_t record_count;
+    float min[VEC_DIMS];
+    float scale[VEC_DIMS];
+} VecHeader;
+
+typedef struct {
+    uint64_t hash;
+    uint64_t row;
+} VecIdEntry;
+
+typedef struct {
+    void *map;
+    size_t map_size;
+    const VecHeader *header;
+    const VecIdEntry *ids;
+    const uint8_t *codes;
+} VectorIndex;
+
+// Candidato a vecino: distancia cuantizada al cuadrado y fila
+typedef struct {
+    float distance;
+    uint32_t row;
+} KnnCandidate;
+
+// Índice de autocompletado generado por "creador -a" (mapeado en memoria)
+typedef struct {
+    uint32_t magic;
+    uint32_t top;
+    uint64_t record_count;
+    uint64_t entry_count;
+    uint64_t hot_count;
+    uint64_t heap_size;
+} CompleteHeader;
+
+typedef struct {
+    uint32_t text_offset;
+    uint16_t length;
+    uint8_t kind;
+    uint8_t reserved;
+    uint32_t count;
+    int32_t year;
+} CompleteEntry;
+
+typedef struct {
+    char prefix[COMPLETE_HOT_PREFIX + 1];
+    uint32_t top[COMPLETE_TOP];
+} CompleteHot;
+
+typedef struct {
+    void *map;
+    size_t map_size;
+    const CompleteHeader *header;
+    const CompleteEntry *entries;
+    const CompleteHot *hot;
+    const char *heap;
+} CompleteIndex;
+
+// Diccionario de textos y columnas generado por "creador" (mapeado en memoria)
+typedef struct {
+    uint32_t magic;
+    uint32_t flags;
+    uint64_t record_count;
+    uint64_t artist_count;
+    uint64_t album_count;
+    uint64_t block_count;
+    uint64_t heap_size;
+} ColumnHeader;
+
+typedef struct {
+    uint32_t offset;
+    uint16_t length;
+    uint16_t block;
+} ColumnString;
+
+typedef struct {
+    uint64_t offset;
+    uint32_t stored_size;
+    uint32_t raw_size;
+} ColumnBlock;
+
+typedef struct {
+    void *map;
+    size_t map_size;
+    const ColumnHeader *header;
+    const ColumnString *artists;
+    const ColumnString *albums;
+    const ColumnBlock *blocks;
+    const uint32_t *artist_ids;
+    const uint32_t *album_ids;
+    const int32_t *durations;
+    const float *danceability;
+    const float *energy;
+    const float *tempo;
+    const int16_t *years;
+    const uint8_t *heap;
+    long cached_block;        // Bloque descomprimido en block_buffer (-1 = ninguno)
+    uint8_t block_buffer[COL_BLOCK_SIZE];
+} ColumnStore;
+
+// Consulta de agregación "funcion:campo:grupo"
+typedef struct {
+    int function;
+    int field;                // ORDER_* (ignorado en count)
+    int group_by;
+} AggregateSpec;
+
+// Acumulador de un grupo
+typedef struct {
+    uint64_t count;
+    double sum;
+    double min;
+    double max;
+} AggregateCell;
+
+// Trabajo de un hilo: un rango de filas y su propia tabla de grupos
+typedef struct {
+    const AggregateSpec *spec;
+    uint64_t first;
+    uint64_t last;
+    uint64_t key_first;       // Tramo de claves de esta pasada
+    uint64_t group_count;
+    AggregateCell *cells;
+} AggregateTask;
+
+// Grupo ya calculado, entre los que se van a devolver
+typedef struct {
+    long key;
+    uint64_t count;
+    double value;
+} AggregateGroup;
+
+// Nombre candidato y su distancia de edición a la consulta
+typedef struct {
+    uint32_t name_id;
+    int distance;
+} FuzzyMatch;
+
+// Marco del buffer pool: una página del archivo de registros
+typedef struct {
+    long page;               // Página cargada (-1 = libre)
+    int next;                // Siguiente marco de la misma cadena hash
+    uint8_t referenced;      // Bit del reloj
+    uint8_t pinned;          // Nunca se desaloja (cabeceras hash)
+} PoolFrame;
+
+// Buffer pool del proceso de búsqueda con presupuesto fijo de memoria.
+// Las lecturas puntuales usan el reloj; los recorridos completos pasan por
+// un anillo pequeño aparte para no desalojar las páginas calientes
+typedef struct {
+    int fd;                  // -1 = sin pool (lectura con stdio)
+    int direct;
+    long file_size;
+    int frame_count;
+    int bucket_mask;
+    PoolFrame *frames;
+    int *buckets;
+    uint8_t *data;           // frame_count + POOL_SCAN_FRAMES páginas alineadas
+    int clock_hand;
+    int scan_hand;
+    long scan_pages[POOL_SCAN_FRAMES];
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t scan_misses;
+} BufferPool;
+
+// Contadores de la consulta en curso (proceso de base de datos)
+typedef struct {
+    uint64_t records_scanned;
+    uint64_t bytes_read;
+    uint64_t chain_links;
+    uint64_t pool_hits;
+    uint64_t block_hits;
+    uint64_t prefix_hits;
+    uint64_t filter_rejects;
+} QueryCounters;
+
+// Intervalo de traza; seq se publica al final para que el volcado
+// descarte ranuras a medio escribir
+typedef struct {
+    uint64_t seq;
+    const char *name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+    uint32_t request_id;
+} TraceEvent;
+
+// Buffer circular de trazas por proceso (sin bloqueos)
+typedef struct {
+    uint64_t head;
+    TraceEvent events[TRACE_CAPACITY];
+} TraceRing;
+
 // Variables globales
-int shm_id, sem_id;
+int shm_id = -1, sem_id = -1;
 SharedData *shared_data;
 pid_t db_pid = -1;
+int metrics_shm_id = -1;
+int batch_shm_id = -1;
+volatile sig_atomic_t server_running = 1;
+MetricsPage *metrics = NULL;
+QueryCounters g_query;
+int trace_enabled = 0;
+const char *trace_path = NULL;
+const char *trace_process_name = "interfaz";
+int trace_owner_pid = 0;   // Proceso que creó el archivo (ya escribió su nombre)
+int trace_dumped = 0;
+uint32_t trace_request_id = 0;
+TraceRing trace_ring;
+MphIndex name_mph;
+BloomFilter name_bloom;
+BucketDirectory bucket_dir;
+SortIndex sort_index;
+FuzzyIndex fuzzy_index;
+uint32_t *fuzzy_candidates;          // FUZZY_MAX_CANDIDATES, reservados con el índice
+VectorIndex vector_index;
+CompleteIndex complete_index;
+ColumnStore column_store;
+BufferPool buffer_pool = {.fd = -1};
+long memory_budget = POOL_DEFAULT_BUDGET;  // -m: pool, índices en memoria y agregación
+long memory_reserved = 0;                 // Parte de memory_budget ya tomada fuera del pool
+long aggregate_budget = AGG_MEMORY_BUDGET;
+int pool_direct = 0;
+FuzzyMatch *fuzzy_matches;
+int ui_order_field = ORDER_NONE;
+int ui_order_desc = 1;
+int ui_limit = MAX_RESULTS;
 
 // Operaciones sobre semáforos
 void sem_wait(int sem_id) {
@@ -65,6 +614,189 @@ void sem_signal(int sem_id) {
     semop(sem_id, &op, 1);
 }
 
+// Reloj monotónico en nanosegundos
+uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Marca de inicio de un intervalo (0 si no hay trazas, para no leer el reloj)
+uint64_t trace_now() {
+    return trace_enabled ? now_ns() : 0;
+}
+
+// Registrar un intervalo [start_ns, ahora] en el buffer circular
+void trace_span(const char *name, uint64_t start_ns) {
+    if (!trace_enabled) return;
+    
+    uint64_t end_ns = now_ns();
+    uint64_t slot = __atomic_fetch_add(&trace_ring.head, 1, __ATOMIC_RELAXED);
+    TraceEvent *event = &trace_ring.events[slot % TRACE_CAPACITY];
+    
+    __atomic_store_n(&event->seq, 0, __ATOMIC_RELAXED);
+    event->name = name;
+    event->start_ns = start_ns;
+    event->end_ns = end_ns;
+    event->request_id = trace_request_id;
+    __atomic_store_n(&event->seq, slot + 1, __ATOMIC_RELEASE);
+}
+
+// Crear el archivo de trazas (formato de arreglo JSON de Chrome trace) con
+// el nombre del proceso que lo abre
+void trace_open(const char *path, const char *process_name) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        perror("Aviso: no se pudo crear el archivo de trazas");
+        return;
+    }
+    
+    trace_process_name = process_name;
+    trace_owner_pid = getpid();
+    fprintf(file, "[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+            "\"args\":{\"name\":\"%s\"}}", trace_owner_pid, trace_owner_pid, process_name);
+    fclose(file);
+    
+    trace_path = path;
+    trace_enabled = 1;
+}
+
+// Reiniciar el buffer en el proceso hijo tras fork()
+void trace_reset(const char *process_name) {
+    trace_ring.head = 0;
+    trace_dumped = 0;
+    trace_process_name = process_name;
+}
+
+// Añadir los eventos de este proceso al archivo de trazas
+void trace_dump() {
+    if (!trace_enabled || trace_dumped) return;
+    trace_dumped = 1;
+    
+    FILE *file = fopen(trace_path, "a");
+    if (!file) return;
+    
+    int pid = getpid();
+    if (pid != trace_owner_pid) {
+        fprintf(file, ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                "\"args\":{\"name\":\"%s\"}}", pid, pid, trace_process_name);
+    }
+    
+    uint64_t head = __atomic_load_n(&trace_ring.head, __ATOMIC_ACQUIRE);
+    uint64_t first = head > TRACE_CAPACITY ? head - TRACE_CAPACITY : 0;
+    
+    for (uint64_t slot = first; slot < head; slot++) {
+        TraceEvent *event = &trace_ring.events[slot % TRACE_CAPACITY];
+        if (__atomic_load_n(&event->seq, __ATOMIC_ACQUIRE) != slot + 1) continue;
+        
+        fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,"
+                "\"dur\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{\"request\":%u}}",
+                event->name, trace_process_name, event->start_ns / 1000.0,
+                (event->end_ns - event->start_ns) / 1000.0, pid, pid, event->request_id);
+    }
+    
+    fclose(file);
+}
+
+// Cerrar el arreglo JSON cuando ambos procesos ya volcaron sus eventos
+void trace_close() {
+    FILE *file = fopen(trace_path, "a");
+    if (!file) return;
+    fprintf(file, "\n]\n");
+    fclose(file);
+    printf("Trazas guardadas en: %s\n", trace_path);
+}
+
+// Crear y adjuntar la página de métricas (opcional: si falla se sigue sin métricas)
+void metrics_init() {
+    metrics_shm_id = shmget(METRICS_SHM_KEY, sizeof(MetricsPage), IPC_CREAT | 0644);
+    if (metrics_shm_id == -1 && errno == EINVAL) {
+        // Segmento más pequeño de una versión anterior: se reemplaza
+        int stale_id = shmget(METRICS_SHM_KEY, 0, 0);
+        if (stale_id != -1) shmctl(stale_id, IPC_RMID, NULL);
+        metrics_shm_id = shmget(METRICS_SHM_KEY, sizeof(MetricsPage), IPC_CREAT | 0644);
+    }
+    if (metrics_shm_id == -1) {
+        perror("Aviso: no se pudo crear la página de métricas");
+        return;
+    }
+    
+    metrics = (MetricsPage*)shmat(metrics_shm_id, NULL, 0);
+    if (metrics == (void*)-1) {
+        perror("Aviso: no se pudo adjuntar la página de métricas");
+        metrics = NULL;
+        shmctl(metrics_shm_id, IPC_RMID, NULL);
+        metrics_shm_id = -1;
+        return;
+    }
+    
+    // La página tiene un solo dueño (su server_pid): si sigue vivo no se toca,
+    // para no borrar sus contadores ni eliminar el segmento al salir. Un dueño
+    // muerto (salida abrupta) se reemplaza; la página se reclama de forma atómica
+    int32_t owner = __atomic_load_n(&metrics->server_pid, __ATOMIC_ACQUIRE);
+    int owner_alive = owner > 0 && owner != getpid() && (kill(owner, 0) == 0 || errno == EPERM);
+    if (owner_alive || !__atomic_compare_exchange_n(&metrics->server_pid, &owner, getpid(), 0,
+                                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        printf("Aviso: el proceso %d ya publica métricas; esta instancia sigue sin ellas\n", owner);
+        shmdt(metrics);
+        metrics = NULL;
+        metrics_shm_id = -1;
+        return;
+    }
+    
+    memset(&metrics->start_time, 0, sizeof(MetricsPage) - offsetof(MetricsPage, start_time));
+    metrics->version = METRICS_VERSION;
+    metrics->start_time = (int64_t)time(NULL);
+    __atomic_store_n(&metrics->magic, METRICS_MAGIC, __ATOMIC_RELEASE);
+}
+
+// Ajustar la profundidad de la cola de solicitudes pendientes
+void metrics_queue_add(int delta) {
+    if (!metrics) return;
+    
+    uint64_t depth = __atomic_add_fetch(&metrics->queue_depth, (uint64_t)(int64_t)delta,
+                                        __ATOMIC_RELAXED);
+    if (delta > 0 && depth > __atomic_load_n(&metrics->max_queue_depth, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&metrics->max_queue_depth, depth, __ATOMIC_RELAXED);
+    }
+}
+
+// Acumular la consulta terminada en los contadores de su tipo
+void metrics_record(int search_type, uint64_t elapsed_ns, int result_count) {
+    if (!metrics || search_type < 0 || search_type >= METRICS_QUERY_TYPES) return;
+    
+    QueryMetrics *m = &metrics->by_type[search_type];
+    uint64_t us = elapsed_ns / 1000;
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && (us >> (bucket + 1)) != 0) {
+        bucket++;
+    }
+    
+    __atomic_fetch_add(&m->requests, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->results, (uint64_t)result_count, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->records_scanned, g_query.records_scanned, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->bytes_read, g_query.bytes_read, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->chain_links, g_query.chain_links, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->pool_hits, g_query.pool_hits, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->block_hits, g_query.block_hits, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->prefix_hits, g_query.prefix_hits, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->filter_rejects, g_query.filter_rejects, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->latency_us_total, us, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->latency_hist[bucket], 1, __ATOMIC_RELAXED);
+    
+    // Solo el proceso de base de datos escribe los máximos
+    if (g_query.chain_links > m->max_chain) {
+        __atomic_store_n(&m->max_chain, g_query.chain_links, __ATOMIC_RELAXED);
+    }
+    if (us > m->latency_us_max) {
+        __atomic_store_n(&m->latency_us_max, us, __ATOMIC_RELAXED);
+    }
+    
+    metrics->pool_hits = buffer_pool.hits;
+    metrics->pool_misses = buffer_pool.misses;
+    metrics->pool_evictions = buffer_pool.evictions;
+}
+
 // Función para limpiar recursos
 void cleanup() {
     if (shared_data) {
@@ -72,9 +804,12 @@ void cleanup() {
         shared_data->request_ready = 1; // Despertar al proceso BD
     }
     
-    if (db_pid != -1) {
+    if (db_pid > 0) {
         kill(db_pid, SIGTERM);
         waitpid(db_pid, NULL, 0);
+        if (trace_enabled) {
+            trace_close();
+        }
     }
     
     // Liberar memoria compartida y semáforos
@@ -85,12 +820,20 @@ void cleanup() {
     if (sem_id != -1) {
         semctl(sem_id, 0, IPC_RMID);
     }
+    if (metrics_shm_id != -1) {
+        shmdt(metrics);
+        shmctl(metrics_shm_id, IPC_RMID, NULL);
+    }
+    if (batch_shm_id != -1) {
+        shmctl(batch_shm_id, IPC_RMID, NULL);
+    }
 }
 
 // Manejador de señales
 void signal_handler(int sig) {
     (void)sig;
     printf("\nFinalizando programa...\n");
+    trace_dump();
     cleanup();
     exit(0);
 }
@@ -107,6 +850,35 @@ int hash_function(const char *name) {
     return hash % HASH_SIZE;
 }
 
+// Hash de 64 bits (FNV-1a) del nombre normalizado a minúsculas
+uint64_t name_hash64(const char *name) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    
+    while (*name) {
+        hash ^= (uint64_t)tolower((unsigned char)*name++);
+        hash *= 0x100000001b3ull;
+    }
+    
+    return hash;
+}
+
+// Mezclador de bits (finalizador de splitmix64)
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+// Ranura de una clave con el desplazamiento de su bucket
+uint64_t mph_slot(uint64_t hash, const MphDisplacement *disp, uint64_t key_count) {
+    uint64_t f1 = mix64(hash ^ 0x9e3779b97f4a7c15ull) % key_count;
+    uint64_t f2 = key_count > 1 ? 1 + mix64(hash ^ 0xc2b2ae3d27d4eb4full) % (key_count - 1) : 0;
+    return (f1 + (disp->d0 * f2) % key_count + disp->d1) % key_count;
+}
+
 // Función para formatear duración
 void format_duration(int duration_ms, char *buffer, size_t buffer_size) {
     int total_seconds = duration_ms / 1000;
@@ -115,10 +887,133 @@ void format_duration(int duration_ms, char *buffer, size_t buffer_size) {
     snprintf(buffer, buffer_size, "%d:%02d", minutes, seconds);
 }
 
+// Nombre legible de un campo de orden
+const char *order_field_name(int field) {
+    switch (field) {
+        case ORDER_ENERGY: return "energía";
+        case ORDER_DANCEABILITY: return "bailabilidad";
+        case ORDER_TEMPO: return "tempo";
+        case ORDER_DURATION: return "duración";
+        case ORDER_YEAR: return "año";
+        default: return "ninguno";
+    }
+}
+
+// Valor de una canción en el campo de orden
+double song_order_value(const Song *song, int field) {
+    switch (field) {
+        case ORDER_ENERGY: return song->energy;
+        case ORDER_DANCEABILITY: return song->danceability;
+        case ORDER_TEMPO: return song->tempo;
+        case ORDER_DURATION: return song->duration_ms;
+        case ORDER_YEAR: return song->year;
+        default: return 0.0;
+    }
+}
+
+// Interpretar "funcion:campo:grupo" (p. ej. "avg:energia:año" o "count::artista");
+// 0 si no es válida
+int aggregate_parse(const char *text, AggregateSpec *spec) {
+    static const struct { int part; const char *name; int value; } names[] = {
+        {0, "count", AGG_COUNT}, {0, "sum", AGG_SUM}, {0, "avg", AGG_AVG},
+        {0, "min", AGG_MIN}, {0, "max", AGG_MAX},
+        {1, "energia", ORDER_ENERGY}, {1, "energía", ORDER_ENERGY},
+        {1, "bailabilidad", ORDER_DANCEABILITY}, {1, "tempo", ORDER_TEMPO},
+        {1, "duracion", ORDER_DURATION}, {1, "duración", ORDER_DURATION},
+        {1, "año", ORDER_YEAR}, {1, "anio", ORDER_YEAR},
+        {2, "año", AGG_BY_YEAR}, {2, "anio", AGG_BY_YEAR}, {2, "decada", AGG_BY_DECADE},
+        {2, "década", AGG_BY_DECADE}, {2, "artista", AGG_BY_ARTIST}, {2, "total", AGG_BY_TOTAL}
+    };
+    
+    char parts[3][32];
+    int part_count = 0;
+    const char *p = text;
+    while (1) {
+        size_t length = strcspn(p, ":");
+        if (part_count == 3 || length >= sizeof(parts[0])) return 0;
+        memcpy(parts[part_count], p, length);
+        parts[part_count++][length] = '\0';
+        if (p[length] == '\0') break;
+        p += length + 1;
+    }
+    if (part_count != 3) return 0;
+    
+    int values[3] = {0, 0, 0};
+    for (size_t n = 0; n < sizeof(names) / sizeof(names[0]); n++) {
+        if (strcasecmp(parts[names[n].part], names[n].name) == 0) {
+            values[names[n].part] = names[n].value;
+        }
+    }
+    spec->function = values[0];
+    spec->field = values[1];
+    spec->group_by = values[2];
+    return spec->function != 0 && spec->group_by != 0 &&
+           (spec->field != ORDER_NONE || spec->function == AGG_COUNT);
+}
+
+const char *aggregate_function_name(int function) {
+    switch (function) {
+        case AGG_COUNT: return "COUNT";
+        case AGG_SUM: return "SUM";
+        case AGG_AVG: return "AVG";
+        case AGG_MIN: return "MIN";
+        case AGG_MAX: return "MAX";
+        default: return "?";
+    }
+}
+
+const char *aggregate_group_name(int group_by) {
+    switch (group_by) {
+        case AGG_BY_YEAR: return "año";
+        case AGG_BY_DECADE: return "década";
+        case AGG_BY_ARTIST: return "artista";
+        default: return "total";
+    }
+}
+
 // Función para mostrar resultados
 void display_results() {
+    uint64_t trace_start = trace_now();
+    
     if (shared_data->result_count == 0) {
         printf("NA - No se encontraron resultados\n");
+        trace_span("display", trace_start);
+        return;
+    }
+    
+    // Sugerencias de autocompletado: término, tipo y popularidad
+    if (shared_data->search_type == 8) {
+        printf("\n=== SUGERENCIAS: %d ===\n", shared_data->result_count);
+        for (int i = 0; i < shared_data->result_count; i++) {
+            Song *song = &shared_data->results[i];
+            printf("%2d. %s (%s) - %d canciones, más reciente %d\n",
+                   i + 1, song->name, song->id, song->duration_ms, song->year);
+        }
+        trace_span("display", trace_start);
+        return;
+    }
+    
+    // Agregación: un grupo por línea con su número de canciones y el valor
+    if (shared_data->search_type == AGGREGATE_SEARCH_TYPE) {
+        AggregateSpec spec;
+        if (aggregate_parse(shared_data->search_term, &spec)) {
+            printf("\n=== AGREGACIÓN: %s(%s) POR %s ===\n", aggregate_function_name(spec.function),
+                   spec.function == AGG_COUNT ? "*" : order_field_name(spec.field),
+                   aggregate_group_name(spec.group_by));
+        }
+        // La respuesta cuenta todos los grupos, pero solo trae los del máximo de resultados
+        int shown = shared_data->result_count < shared_data->limit ?
+                    shared_data->result_count : shared_data->limit;
+        for (int i = 0; i < shown; i++) {
+            Song *song = &shared_data->results[i];
+            printf("%3d. %-40s %8d canciones  %14.3f\n",
+                   i + 1, song->name, song->duration_ms, song->energy);
+        }
+        if (shown < shared_data->result_count) {
+            printf("\n... y %d grupos más (máximo de resultados: %d; -b con -n 0 los devuelve todos)\n",
+                   shared_data->result_count - shown, shared_data->limit);
+        }
+        trace_span("display", trace_start);
         return;
     }
     
@@ -145,6 +1040,10 @@ void display_results() {
             printf("\n%d. %s - %s\n", i + 1, song->name, song->artists);
             printf("   Álbum: %s | Año: %d | Duración: %s\n", 
                    song->album, song->year, duration_str);
+            if (shared_data->order_field != ORDER_NONE && shared_data->search_type != 7) {
+                printf("   Orden por %s: %.3f\n", order_field_name(shared_data->order_field),
+                       song_order_value(song, shared_data->order_field));
+            }
             if (i == 0) {
                 printf("   Bailabilidad: %.3f | Energía: %.3f | Tempo: %.1f BPM\n",
                        song->danceability, song->energy, song->tempo);
@@ -155,6 +1054,8 @@ void display_results() {
     if (shared_data->result_count > 10) {
         printf("\n... y %d resultados más\n", shared_data->result_count - 10);
     }
+    
+    trace_span("display", trace_start);
 }
 
 // Función segura para leer entrada
@@ -173,204 +1074,2342 @@ int safe_scanf_int(const char *format, int *value) {
     return result;
 }
 
-// Función para buscar por nombre exacto
-int search_by_exact_name(const char *filename, const char *name, Song *results, int max_results) {
-    FILE *file = fopen(filename, "rb");
-    if (!file) return 0;
+// Leer una página del archivo en un marco; lo que pase del final queda en cero
+int pool_load_page(BufferPool *pool, long page, uint8_t *frame_data) {
+    ssize_t n = pread(pool->fd, frame_data, POOL_PAGE_SIZE, (off_t)page * POOL_PAGE_SIZE);
+    if (n < 0) return 0;
+    if (n < POOL_PAGE_SIZE) memset(frame_data + n, 0, POOL_PAGE_SIZE - n);
+    return 1;
+}
+
+// Buscar una página en la tabla hash del pool; -1 si no está
+int pool_lookup(const BufferPool *pool, long page) {
+    int frame = pool->buckets[page & pool->bucket_mask];
+    while (frame != -1 && pool->frames[frame].page != page) {
+        frame = pool->frames[frame].next;
+    }
+    return frame;
+}
+
+// Quitar un marco de su cadena hash
+void pool_unlink(BufferPool *pool, int frame) {
+    int *link = &pool->buckets[pool->frames[frame].page & pool->bucket_mask];
+    while (*link != frame) link = &pool->frames[*link].next;
+    *link = pool->frames[frame].next;
+}
+
+// Página para una lectura puntual: si no está se desaloja un marco con el
+// reloj (segunda oportunidad), sin tocar los fijados
+const uint8_t *pool_fetch(BufferPool *pool, long page, int pin) {
+    int frame = pool_lookup(pool, page);
+    if (frame != -1) {
+        pool->frames[frame].referenced = 1;
+        pool->frames[frame].pinned |= (uint8_t)pin;
+        pool->hits++;
+        g_query.pool_hits++;
+        return pool->data + (size_t)frame * POOL_PAGE_SIZE;
+    }
     
-    HashEntry hash_table[HASH_SIZE];
-    if (fread(hash_table, sizeof(HashEntry), HASH_SIZE, file) != HASH_SIZE) {
-        fclose(file);
-        return 0;
+    while (1) {
+        frame = pool->clock_hand;
+        pool->clock_hand = (pool->clock_hand + 1) % pool->frame_count;
+        PoolFrame *f = &pool->frames[frame];
+        if (f->pinned) continue;
+        if (f->page != -1 && f->referenced) {
+            f->referenced = 0;
+            continue;
+        }
+        if (f->page != -1) {
+            pool_unlink(pool, frame);
+            pool->evictions++;
+        }
+        break;
     }
     
-    int hash_index = hash_function(name);
-    long current_pos = hash_table[hash_index].first_position;
-    int found = 0;
+    PoolFrame *f = &pool->frames[frame];
+    uint8_t *frame_data = pool->data + (size_t)frame * POOL_PAGE_SIZE;
+    f->page = -1;
+    if (!pool_load_page(pool, page, frame_data)) return NULL;
+    pool->misses++;
     
-    while (current_pos != -1 && found < max_results) {
-        fseek(file, current_pos, SEEK_SET);
-        Song song;
-        if (fread(&song, sizeof(Song), 1, file) != 1) break;
-        
-        if (strcasecmp(song.name, name) == 0) {
-            results[found++] = song;
+    f->page = page;
+    f->referenced = 1;
+    f->pinned = (uint8_t)pin;
+    f->next = pool->buckets[page & pool->bucket_mask];
+    pool->buckets[page & pool->bucket_mask] = frame;
+    return frame_data;
+}
+
+// Página para un recorrido completo: se aprovecha si ya está en el pool,
+// pero si no se carga en el anillo de recorrido y no desaloja nada
+const uint8_t *pool_fetch_scan(BufferPool *pool, long page) {
+    int frame = pool_lookup(pool, page);
+    if (frame == -1) {
+        for (int i = 0; i < POOL_SCAN_FRAMES; i++) {
+            if (pool->scan_pages[i] == page) {
+                frame = pool->frame_count + i;
+                break;
+            }
         }
-        
-        current_pos = song.next;
+    }
+    if (frame != -1) {
+        pool->hits++;
+        g_query.pool_hits++;
+        return pool->data + (size_t)frame * POOL_PAGE_SIZE;
     }
     
-    fclose(file);
-    return found;
+    int slot = pool->scan_hand;
+    pool->scan_hand = (pool->scan_hand + 1) % POOL_SCAN_FRAMES;
+    uint8_t *frame_data = pool->data + (size_t)(pool->frame_count + slot) * POOL_PAGE_SIZE;
+    pool->scan_pages[slot] = -1;
+    if (!pool_load_page(pool, page, frame_data)) return NULL;
+    pool->scan_pages[slot] = page;
+    pool->misses++;
+    pool->scan_misses++;
+    return frame_data;
 }
 
-// Función para buscar por palabra en el nombre
-int search_by_name_word(const char *filename, const char *word, Song *results, int max_results) {
-    FILE *file = fopen(filename, "rb");
-    if (!file) return 0;
+// Copiar "size" bytes desde "offset" a través del pool; devuelve los copiados
+size_t pool_read(BufferPool *pool, long offset, void *dest, size_t size, int scan) {
+    if (offset < 0 || offset >= pool->file_size) return 0;
+    if ((long)size > pool->file_size - offset) size = pool->file_size - offset;
+    
+    size_t copied = 0;
+    while (copied < size) {
+        long page = (offset + (long)copied) / POOL_PAGE_SIZE;
+        size_t in_page = (size_t)((offset + (long)copied) % POOL_PAGE_SIZE);
+        size_t chunk = POOL_PAGE_SIZE - in_page;
+        if (chunk > size - copied) chunk = size - copied;
+        
+        const uint8_t *data = scan ? pool_fetch_scan(pool, page) : pool_fetch(pool, page, 0);
+        if (!data) break;
+        memcpy((uint8_t*)dest + copied, data + in_page, chunk);
+        copied += chunk;
+    }
+    return copied;
+}
+
+// Tomar "bytes" del presupuesto de -m para una estructura que vive en
+// memoria; siempre queda lugar para el pool mínimo y con -m 0 no hay límite.
+// 0 (con aviso) si no cabe: el índice se ignora y se usa el camino sin él
+int memory_reserve(long bytes, const char *what) {
+    if (memory_budget > 0 && memory_reserved + bytes > memory_budget - (long)POOL_MIN_BYTES) {
+        printf("Aviso: %s (%ld KB) no cabe en el presupuesto de memoria (-m), se ignora\n",
+               what, bytes / 1024);
+        return 0;
+    }
+    memory_reserved += bytes;
+    return 1;
+}
+
+// Abrir el archivo de registros con un pool de "budget" bytes, contando el
+// anillo de recorridos y los metadatos de cada marco; las páginas de la
+// tabla hash quedan fijadas porque toda búsqueda exacta empieza ahí
+int pool_open(BufferPool *pool, const char *filename, long budget, int direct) {
+    memset(pool, 0, sizeof(BufferPool));
+    pool->fd = -1;
+    
+    pool->frame_count = (int)((budget - POOL_SCAN_FRAMES * POOL_PAGE_SIZE) / (long)POOL_FRAME_BYTES);
+    if (pool->frame_count < POOL_MIN_FRAMES) pool->frame_count = POOL_MIN_FRAMES;
+    int bucket_count = 1;
+    while (bucket_count < pool->frame_count) bucket_count <<= 1;
+    pool->bucket_mask = bucket_count - 1;
+    
+    pool->frames = malloc(sizeof(PoolFrame) * pool->frame_count);
+    pool->buckets = malloc(sizeof(int) * bucket_count);
+    void *data = NULL;
+    if (!pool->frames || !pool->buckets ||
+        posix_memalign(&data, POOL_PAGE_SIZE,
+                       (size_t)(pool->frame_count + POOL_SCAN_FRAMES) * POOL_PAGE_SIZE) != 0) {
+        printf("Aviso: memoria insuficiente para el buffer pool, se usa stdio\n");
+        free(pool->frames);
+        free(pool->buckets);
+        return 0;
+    }
+    pool->data = data;
+    
+    // O_DIRECT evita la caché de páginas del kernel; si el sistema de
+    // archivos no lo admite se abre de forma normal
+    int fd = -1;
+    if (direct) {
+        fd = open(filename, O_RDONLY | O_DIRECT);
+        if (fd == -1) printf("Aviso: O_DIRECT no disponible para %s, se usa lectura normal\n", filename);
+    }
+    if (fd == -1) fd = open(filename, O_RDONLY);
+    
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) == -1) {
+        if (fd != -1) close(fd);
+        free(pool->frames);
+        free(pool->buckets);
+        free(pool->data);
+        return 0;
+    }
+    pool->fd = fd;
+    pool->direct = direct && (fcntl(fd, F_GETFL) & O_DIRECT) != 0;
+    pool->file_size = (long)st.st_size;
+    
+    for (int i = 0; i < pool->frame_count; i++) {
+        pool->frames[i].page = -1;
+        pool->frames[i].referenced = 0;
+        pool->frames[i].pinned = 0;
+    }
+    for (int i = 0; i < bucket_count; i++) pool->buckets[i] = -1;
+    for (int i = 0; i < POOL_SCAN_FRAMES; i++) pool->scan_pages[i] = -1;
+    
+    long header_pages = ((long)(sizeof(HashEntry) * HASH_SIZE) + POOL_PAGE_SIZE - 1) / POOL_PAGE_SIZE;
+    for (long page = 0; page < header_pages && page < pool->frame_count / 2; page++) {
+        pool_fetch(pool, page, 1);
+    }
+    pool->hits = pool->misses = 0;
+    return 1;
+}
+
+void pool_close(BufferPool *pool) {
+    if (pool->fd == -1) return;
+    printf("Buffer pool: %llu aciertos, %llu fallos (%llu en recorridos), %llu desalojos\n",
+           (unsigned long long)pool->hits, (unsigned long long)pool->misses,
+           (unsigned long long)pool->scan_misses, (unsigned long long)pool->evictions);
+    close(pool->fd);
+    free(pool->frames);
+    free(pool->buckets);
+    free(pool->data);
+    pool->fd = -1;
+}
+
+// Leer la tabla hash del inicio del archivo
+int read_hash_table(FILE *file, HashEntry *hash_table) {
+    if (buffer_pool.fd != -1) {
+        if (pool_read(&buffer_pool, 0, hash_table, sizeof(HashEntry) * HASH_SIZE, 0) !=
+            sizeof(HashEntry) * HASH_SIZE) {
+            return 0;
+        }
+    } else {
+        fseek(file, 0, SEEK_SET);
+        if (fread(hash_table, sizeof(HashEntry), HASH_SIZE, file) != HASH_SIZE) {
+            return 0;
+        }
+    }
+    g_query.bytes_read += sizeof(HashEntry) * HASH_SIZE;
+    return 1;
+}
+
+// Pasar un registro a canción. El álbum y los artistas quedan vacíos hasta
+// songs_load_texts: los recorridos deciden sin leer el texto
+void record_to_song(const SongRecord *record, Song *song) {
+    memcpy(song->id, record->id, sizeof(song->id));
+    memcpy(song->name, record->name, sizeof(song->name));
+    song->album[0] = '\0';
+    song->artists[0] = '\0';
+    song->album_id = record->album_id;
+    song->artist_id = record->artist_id;
+    song->year = record->year;
+    song->duration_ms = record->duration_ms;
+    song->danceability = record->danceability;
+    song->energy = record->energy;
+    song->tempo = record->tempo;
+    song->next = record->next;
+}
+
+// Leer una canción en la posición indicada
+int read_song(FILE *file, long position, Song *song) {
+    SongRecord record;
+    if (buffer_pool.fd != -1) {
+        if (pool_read(&buffer_pool, position, &record, sizeof(SongRecord), 0) != sizeof(SongRecord)) {
+            return 0;
+        }
+    } else {
+        fseek(file, position, SEEK_SET);
+        if (fread(&record, sizeof(SongRecord), 1, file) != 1) {
+            return 0;
+        }
+    }
+    record_to_song(&record, song);
+    g_query.records_scanned++;
+    g_query.bytes_read += sizeof(SongRecord);
+    return 1;
+}
+
+// Leer hasta SCAN_BATCH canciones contiguas; devuelve cuántas se leyeron.
+// Es la lectura de los recorridos completos, así que usa el anillo del pool
+int read_songs(FILE *file, long position, Song *songs, int count) {
+    SongRecord records[SCAN_BATCH];
+    if (count > SCAN_BATCH) count = SCAN_BATCH;
+    
+    int read_count;
+    if (buffer_pool.fd != -1) {
+        read_count = (int)(pool_read(&buffer_pool, position, records, sizeof(SongRecord) * count, 1) /
+                           sizeof(SongRecord));
+    } else {
+        fseek(file, position, SEEK_SET);
+        read_count = (int)fread(records, sizeof(SongRecord), count, file);
+    }
+    for (int i = 0; i < read_count; i++) {
+        record_to_song(&records[i], &songs[i]);
+    }
+    g_query.records_scanned += read_count;
+    g_query.bytes_read += sizeof(SongRecord) * read_count;
+    return read_count;
+}
+
+// Preparar un recorrido completo de la base
+int cursor_open(SongCursor *cursor, FILE *file) {
+    cursor->file = file;
+    cursor->batch_count = 0;
+    cursor->batch_index = 0;
+    
+    if (bucket_dir.loaded) {
+        cursor->position = sizeof(HashEntry) * HASH_SIZE;
+        cursor->remaining = 0;
+        for (int i = 0; i < HASH_SIZE; i++) {
+            cursor->remaining += bucket_dir.runs[i].count;
+        }
+        return 1;
+    }
+    
+    if (!read_hash_table(file, cursor->hash_table)) return 0;
+    cursor->bucket = 0;
+    cursor->current_pos = cursor->hash_table[0].first_position;
+    return 1;
+}
+
+// Siguiente canción del recorrido, o NULL al terminar
+Song *cursor_next(SongCursor *cursor) {
+    if (bucket_dir.loaded) {
+        if (cursor->batch_index == cursor->batch_count) {
+            if (cursor->remaining == 0) return NULL;
+            int wanted = cursor->remaining < SCAN_BATCH ? (int)cursor->remaining : SCAN_BATCH;
+            cursor->batch_count = read_songs(cursor->file, cursor->position, cursor->batch, wanted);
+            if (cursor->batch_count == 0) return NULL;
+            cursor->batch_index = 0;
+            cursor->position += (long)sizeof(SongRecord) * cursor->batch_count;
+            cursor->remaining -= cursor->batch_count;
+        }
+        return &cursor->batch[cursor->batch_index++];
+    }
+    
+    while (1) {
+        while (cursor->current_pos == -1) {
+            if (++cursor->bucket >= HASH_SIZE) return NULL;
+            cursor->current_pos = cursor->hash_table[cursor->bucket].first_position;
+        }
+        
+        if (read_songs(cursor->file, cursor->current_pos, &cursor->batch[0], 1) == 1) {
+            cursor->current_pos = cursor->batch[0].next;
+            return &cursor->batch[0];
+        }
+        cursor->current_pos = -1; // Cadena dañada: pasar al siguiente bucket
+    }
+}
+
+// Número de registros de canciones en el archivo binario
+long count_records(FILE *file) {
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file) - (long)(sizeof(HashEntry) * HASH_SIZE);
+    return size > 0 ? size / (long)sizeof(SongRecord) : 0;
+}
+
+// Cargar el índice MPH si existe y corresponde a la base actual
+int mph_load(MphIndex *index, const char *mph_filename, long record_count) {
+    memset(index, 0, sizeof(MphIndex));
+    
+    FILE *file = fopen(mph_filename, "rb");
+    if (!file) return 0;
+    
+    MphHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != MPH_MAGIC ||
+        header.record_count != (uint64_t)record_count || header.key_count == 0) {
+        printf("Aviso: índice %s ausente o desactualizado, se ignora\n", mph_filename);
+        fclose(file);
+        return 0;
+    }
+    
+    // El tamaño del archivo debe cuadrar con la cabecera antes de reservar nada
+    struct stat st;
+    uint64_t expected = sizeof(MphHeader) + sizeof(MphDisplacement) * header.bucket_count +
+                        sizeof(MphSlot) * header.key_count + sizeof(int64_t) * header.group_count;
+    if (header.bucket_count == 0 || header.bucket_count > header.key_count + 1 ||
+        header.key_count > header.record_count || header.group_count > header.record_count ||
+        fstat(fileno(file), &st) == -1 || (uint64_t)st.st_size != expected) {
+        printf("Aviso: índice %s dañado, se ignora\n", mph_filename);
+        fclose(file);
+        return 0;
+    }
+    
+    long disp_bytes = (long)(sizeof(MphDisplacement) * header.bucket_count);
+    if (!memory_reserve(disp_bytes, mph_filename)) {
+        fclose(file);
+        return 0;
+    }
+    MphDisplacement *disp = malloc(disp_bytes);
+    if (!disp || fread(disp, sizeof(MphDisplacement), header.bucket_count, file) != header.bucket_count) {
+        free(disp);
+        fclose(file);
+        memory_reserved -= disp_bytes;
+        return 0;
+    }
+    
+    index->file = file;
+    index->header = header;
+    index->disp = disp;
+    return 1;
+}
+
+void mph_free(MphIndex *index) {
+    if (index->file) fclose(index->file);
+    free(index->disp);
+    memset(index, 0, sizeof(MphIndex));
+}
+
+// Ranura de un nombre: una lectura. Devuelve 0 si la huella no coincide
+int mph_find(MphIndex *index, const char *name, MphSlot *slot) {
+    uint64_t hash = name_hash64(name);
+    const MphHeader *header = &index->header;
+    uint64_t bucket = mix64(hash) % header->bucket_count;
+    uint64_t slot_index = mph_slot(hash, &index->disp[bucket], header->key_count);
+    
+    long slots_offset = sizeof(MphHeader) + sizeof(MphDisplacement) * header->bucket_count;
+    fseek(index->file, slots_offset + (long)(slot_index * sizeof(MphSlot)), SEEK_SET);
+    if (fread(slot, sizeof(MphSlot), 1, index->file) != 1) return 0;
+    g_query.bytes_read += sizeof(MphSlot);
+    
+    return slot->fingerprint == (uint32_t)(hash >> 32);
+}
+
+// Posiciones candidatas de una ranura a partir de la número first, en el
+// orden de la cadena (la lista de duplicados si el nombre se repite)
+int mph_positions(MphIndex *index, const MphSlot *slot, uint32_t first, long *positions,
+                  int max_positions) {
+    if (first >= slot->count || max_positions <= 0) return 0;
+    if (slot->count == 1) {
+        positions[0] = slot->position;
+        return 1;
+    }
+    
+    uint32_t left = slot->count - first;
+    int count = left < (uint32_t)max_positions ? (int)left : max_positions;
+    if (count > MAX_RESULTS) count = MAX_RESULTS;
+    int64_t group[MAX_RESULTS];
+    fseek(index->file, slot->position + (long)(sizeof(int64_t) * first), SEEK_SET);
+    if (fread(group, sizeof(int64_t), count, index->file) != (size_t)count) return 0;
+    g_query.bytes_read += sizeof(int64_t) * count;
+    
+    for (int i = 0; i < count; i++) {
+        positions[i] = group[i];
+    }
+    return count;
+}
+
+// Cargar el directorio de buckets si la base fue agrupada por "creador -c"
+int bucket_dir_load(BucketDirectory *dir, const char *dir_filename, long record_count) {
+    memset(dir, 0, sizeof(BucketDirectory));
+    
+    FILE *file = fopen(dir_filename, "rb");
+    if (!file) return 0;
+    
+    DirHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != DIR_MAGIC ||
+        header.record_count != (uint64_t)record_count ||
+        fread(dir->runs, sizeof(BucketRun), HASH_SIZE, file) != HASH_SIZE) {
+        printf("Aviso: directorio %s ausente o desactualizado, se ignora\n", dir_filename);
+        fclose(file);
+        return 0;
+    }
+    fclose(file);
+    
+    dir->loaded = 1;
+    return 1;
+}
+
+// Cargar el filtro de Bloom completo en memoria
+int bloom_load(BloomFilter *filter, const char *bloom_filename, long record_count) {
+    memset(filter, 0, sizeof(BloomFilter));
+    
+    FILE *file = fopen(bloom_filename, "rb");
+    if (!file) return 0;
+    
+    BloomHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != BLOOM_MAGIC ||
+        header.record_count != (uint64_t)record_count || header.block_count == 0 ||
+        header.hashes == 0 || header.hashes > BLOOM_MAX_HASHES) {
+        printf("Aviso: filtro %s ausente o desactualizado, se ignora\n", bloom_filename);
+        fclose(file);
+        return 0;
+    }
+    
+    size_t words = header.block_count * BLOOM_BLOCK_WORDS;
+    if (!memory_reserve((long)(sizeof(uint64_t) * words), bloom_filename)) {
+        fclose(file);
+        return 0;
+    }
+    uint64_t *blocks = malloc(sizeof(uint64_t) * words);
+    if (!blocks || fread(blocks, sizeof(uint64_t), words, file) != words) {
+        free(blocks);
+        fclose(file);
+        memory_reserved -= (long)(sizeof(uint64_t) * words);
+        return 0;
+    }
+    fclose(file);
+    
+    filter->header = header;
+    filter->blocks = blocks;
+    return 1;
+}
+
+// 0 = el nombre seguro no existe; 1 = puede existir
+int bloom_may_contain(const BloomFilter *filter, const char *name) {
+    uint64_t hash = name_hash64(name);
+    const uint64_t *block = filter->blocks +
+                            (mix64(hash) % filter->header.block_count) * BLOOM_BLOCK_WORDS;
+    uint64_t bits = mix64(hash ^ 0x5851f42d4c957f2dull);
+    
+    for (uint32_t i = 0; i < filter->header.hashes; i++) {
+        unsigned bit = (bits >> (9 * i)) & 511;
+        if (!(block[bit >> 6] & (1ull << (bit & 63)))) return 0;
+    }
+    return 1;
+}
+
+void topk_init(TopK *topk, int field, int desc, int capacity) {
+    topk->field = field;
+    topk->desc = desc;
+    topk->capacity = capacity < MAX_RESULTS ? capacity : MAX_RESULTS;
+    topk->count = 0;
+}
+
+// 1 si a va después de b en el orden pedido
+int topk_worse(const TopK *topk, const Song *a, const Song *b) {
+    double va = song_order_value(a, topk->field);
+    double vb = song_order_value(b, topk->field);
+    return topk->desc ? va < vb : va > vb;
+}
+
+void topk_sift_down(TopK *topk, int i) {
+    while (1) {
+        int worst = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < topk->count && topk_worse(topk, &topk->items[left], &topk->items[worst])) worst = left;
+        if (right < topk->count && topk_worse(topk, &topk->items[right], &topk->items[worst])) worst = right;
+        if (worst == i) return;
+        
+        Song tmp = topk->items[i];
+        topk->items[i] = topk->items[worst];
+        topk->items[worst] = tmp;
+        i = worst;
+    }
+}
+
+// Insertar una coincidencia; solo se copia si entra entre los K mejores
+void topk_push(TopK *topk, const Song *song) {
+    if (topk->count < topk->capacity) {
+        int i = topk->count++;
+        topk->items[i] = *song;
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!topk_worse(topk, &topk->items[i], &topk->items[parent])) break;
+            Song tmp = topk->items[i];
+            topk->items[i] = topk->items[parent];
+            topk->items[parent] = tmp;
+            i = parent;
+        }
+    } else if (topk->capacity > 0 && topk_worse(topk, &topk->items[0], song)) {
+        topk->items[0] = *song;
+        topk_sift_down(topk, 0);
+    }
+}
+
+// Vaciar el montículo en results, del mejor al peor
+int topk_drain(TopK *topk, Song *results) {
+    int total = topk->count;
+    for (int i = total - 1; i >= 0; i--) {
+        results[i] = topk->items[0];
+        topk->items[0] = topk->items[--topk->count];
+        topk_sift_down(topk, 0);
+    }
+    return total;
+}
+
+// Abrir el índice ordenado si corresponde a la base actual
+int sort_index_load(SortIndex *index, const char *sort_filename, long record_count) {
+    memset(index, 0, sizeof(SortIndex));
+    
+    FILE *file = fopen(sort_filename, "rb");
+    if (!file) return 0;
+    
+    SortHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != SORT_MAGIC ||
+        header.record_count != (uint64_t)record_count || header.field_count != ORDER_FIELDS) {
+        printf("Aviso: índice %s ausente o desactualizado, se ignora\n", sort_filename);
+        fclose(file);
+        return 0;
+    }
+    
+    index->file = file;
+    index->header = header;
+    return 1;
+}
+
+// Copia en minúsculas para comparar sin distinguir mayúsculas
+void to_lower_copy(char *dest, const char *src, size_t size) {
+    size_t i = 0;
+    for (; i + 1 < size && src[i]; i++) {
+        dest[i] = tolower((unsigned char)src[i]);
+    }
+    dest[i] = '\0';
+}
+
+// ORDER BY con índice ordenado, solo para la búsqueda por año: el año viaja
+// en cada entrada, así que se recorre el campo en el orden pedido sin leer
+// los registros que no coinciden y se termina en cuanto hay "limit"
+// coincidencias, que ya son las K mejores. Si además se ordena por año, las
+// coincidencias son un tramo contiguo que se ubica por búsqueda binaria.
+// Palabra y artista necesitan el registro para decidir: una lectura aleatoria
+// por entrada sería peor que el recorrido secuencial con TopK, así que
+// devuelven -1 (igual que cualquier consulta que no pueda usar el índice).
+int search_ordered_by_index(const char *filename, const Query *query, Song *results, int limit) {
+    if (!sort_index.file || query->search_type != 4) return -1;
+    
+    FILE *file = fopen(filename, "rb");
+    if (!file) return 0;
+    
+    long entries = (long)sort_index.header.record_count;
+    long base = sizeof(SortHeader) + (long)sizeof(SortEntry) * entries * (query->order_field - 1);
+    long range_first = 0, range_last = entries;
+    SortEntry batch[SORT_BATCH];
+    
+    uint64_t trace_start = trace_now();
+    if (query->order_field == ORDER_YEAR) {
+        // Primera entrada con año >= buscado y primera con año > buscado
+        for (int bound = 0; bound < 2; bound++) {
+            long low = 0, high = entries;
+            while (low < high) {
+                long middle = low + (high - low) / 2;
+                SortEntry entry;
+                fseek(sort_index.file, base + middle * (long)sizeof(SortEntry), SEEK_SET);
+                if (fread(&entry, sizeof(entry), 1, sort_index.file) != 1) break;
+                g_query.bytes_read += sizeof(entry);
+                if (entry.year < query->search_year ||
+                    (bound == 1 && entry.year == query->search_year)) {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+            if (bound == 0) range_first = low;
+            else range_last = low;
+        }
+        trace_span("index_lookup", trace_start);
+        trace_start = trace_now();
+    }
+    
+    long span = range_last - range_first;
+    long done = 0;
+    int found = 0;
+    while (found < limit && done < span) {
+        int n = span - done < SORT_BATCH ? (int)(span - done) : SORT_BATCH;
+        long first = range_first + (query->order_desc ? span - done - n : done);
+        
+        fseek(sort_index.file, base + first * (long)sizeof(SortEntry), SEEK_SET);
+        if (fread(batch, sizeof(SortEntry), n, sort_index.file) != (size_t)n) break;
+        g_query.bytes_read += sizeof(SortEntry) * n;
+        
+        for (int k = 0; k < n && found < limit; k++) {
+            const SortEntry *entry = &batch[query->order_desc ? n - 1 - k : k];
+            if (entry->year != query->search_year) continue;
+            
+            Song song;
+            if (!read_song(file, entry->position, &song)) continue;
+            if (song.year == query->search_year) {
+                results[found++] = song;
+            }
+        }
+        done += n;
+    }
+    trace_span("scan", trace_start);
+    
+    fclose(file);
+    return found;
+}
+
+// Mapear el diccionario de borrados si corresponde a la base actual
+int fuzzy_load(FuzzyIndex *index, const char *fuzzy_filename, long record_count) {
+    memset(index, 0, sizeof(FuzzyIndex));
+    
+    int fd = open(fuzzy_filename, O_RDONLY);
+    if (fd == -1) return 0;
+    
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(FuzzyHeader)) {
+        close(fd);
+        return 0;
+    }
+    
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+    
+    const FuzzyHeader *header = map;
+    size_t expected = sizeof(FuzzyHeader) + sizeof(FuzzyPair) * header->pair_count +
+                      sizeof(FuzzyName) * header->name_count +
+                      sizeof(int64_t) * header->position_count + header->heap_size;
+    if (header->magic != FUZZY_MAGIC || header->prefix_length != FUZZY_PREFIX ||
+        header->record_count != (uint64_t)record_count || expected != (size_t)st.st_size) {
+        printf("Aviso: índice %s ausente o desactualizado, se ignora\n", fuzzy_filename);
+        munmap(map, st.st_size);
+        return 0;
+    }
+    
+    // Los candidatos de cada consulta viven en memoria y cuentan en -m
+    long buffer_bytes = (long)(sizeof(uint32_t) + sizeof(FuzzyMatch)) * FUZZY_MAX_CANDIDATES;
+    if (!memory_reserve(buffer_bytes, fuzzy_filename)) {
+        munmap(map, st.st_size);
+        return 0;
+    }
+    fuzzy_candidates = malloc(sizeof(uint32_t) * FUZZY_MAX_CANDIDATES);
+    fuzzy_matches = malloc(sizeof(FuzzyMatch) * FUZZY_MAX_CANDIDATES);
+    if (!fuzzy_candidates || !fuzzy_matches) {
+        free(fuzzy_candidates);
+        free(fuzzy_matches);
+        fuzzy_candidates = NULL;
+        fuzzy_matches = NULL;
+        munmap(map, st.st_size);
+        memory_reserved -= buffer_bytes;
+        return 0;
+    }
+    
+    index->map = map;
+    index->map_size = st.st_size;
+    index->header = header;
+    index->pairs = (const FuzzyPair*)(header + 1);
+    index->names = (const FuzzyName*)(index->pairs + header->pair_count);
+    index->positions = (const int64_t*)(index->names + header->name_count);
+    index->heap = (const char*)(index->positions + header->position_count);
+    return 1;
+}
+
+// Hash de 32 bits (FNV-1a) de un borrado
+uint32_t delete_hash32(const char *text) {
+    uint32_t hash = 2166136261u;
+    while (*text) {
+        hash ^= (unsigned char)*text++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Borrados de hasta FUZZY_MAX_EDITS caracteres del prefijo (igual que creador)
+int fuzzy_deletes(const char *word, char deletes[][FUZZY_PREFIX + 1]) {
+    size_t length = strlen(word);
+    if (length > FUZZY_PREFIX) length = FUZZY_PREFIX;
+    
+    memcpy(deletes[0], word, length);
+    deletes[0][length] = '\0';
+    int count = 1;
+    int level_start = 0;
+    
+    for (int edit = 0; edit < FUZZY_MAX_EDITS; edit++) {
+        int level_end = count;
+        for (int i = level_start; i < level_end; i++) {
+            size_t len = strlen(deletes[i]);
+            for (size_t k = 0; k < len && count < FUZZY_MAX_DELETES; k++) {
+                char candidate[FUZZY_PREFIX + 1];
+                memcpy(candidate, deletes[i], k);
+                memcpy(candidate + k, deletes[i] + k + 1, len - k);
+                
+                int j;
+                for (j = 0; j < count && strcmp(deletes[j], candidate) != 0; j++);
+                if (j == count) strcpy(deletes[count++], candidate);
+            }
+        }
+        level_start = level_end;
+    }
+    
+    return count;
+}
+
+// Distancia de Levenshtein acotada: -1 si supera max_distance
+int bounded_edit_distance(const char *a, size_t len_a, const char *b, size_t len_b,
+                          int max_distance) {
+    if ((len_a > len_b ? len_a - len_b : len_b - len_a) > (size_t)max_distance) return -1;
+    
+    int row[MAX_TITLE + 1];
+    int prev_row[MAX_TITLE + 1];
+    if (len_b > MAX_TITLE) len_b = MAX_TITLE;
+    for (size_t j = 0; j <= len_b; j++) prev_row[j] = (int)j;
+    
+    for (size_t i = 1; i <= len_a; i++) {
+        row[0] = (int)i;
+        int row_min = row[0];
+        for (size_t j = 1; j <= len_b; j++) {
+            int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+            int best = prev_row[j - 1] + cost;
+            if (prev_row[j] + 1 < best) best = prev_row[j] + 1;
+            if (row[j - 1] + 1 < best) best = row[j - 1] + 1;
+            row[j] = best;
+            if (best < row_min) row_min = best;
+        }
+        if (row_min > max_distance) return -1;
+        memcpy(prev_row, row, sizeof(int) * (len_b + 1));
+    }
+    
+    return prev_row[len_b] <= max_distance ? prev_row[len_b] : -1;
+}
+
+int compare_uint32(const void *a, const void *b) {
+    uint32_t ua = *(const uint32_t*)a, ub = *(const uint32_t*)b;
+    return ua < ub ? -1 : (ua > ub);
+}
+
+// Más cercanos primero; a igual distancia, los nombres con más canciones
+int compare_fuzzy_matches(const void *a, const void *b) {
+    const FuzzyMatch *ma = a, *mb = b;
+    if (ma->distance != mb->distance) return ma->distance - mb->distance;
+    uint32_t ca = fuzzy_index.names[ma->name_id].count;
+    uint32_t cb = fuzzy_index.names[mb->name_id].count;
+    if (ca != cb) return ca > cb ? -1 : 1;
+    return ma->name_id < mb->name_id ? -1 : (ma->name_id > mb->name_id);
+}
+
+// Nombres del diccionario a distancia <= FUZZY_MAX_EDITS de la consulta,
+// ordenados por cercanía; devuelve cuántos hay en fuzzy_matches
+int fuzzy_lookup(const char *lower_query) {
+    char deletes[FUZZY_MAX_DELETES][FUZZY_PREFIX + 1];
+    int delete_count = fuzzy_deletes(lower_query, deletes);
+    int candidate_count = 0;
+    uint64_t pair_count = fuzzy_index.header->pair_count;
+    
+    for (int d = 0; d < delete_count; d++) {
+        uint32_t hash = delete_hash32(deletes[d]);
+        
+        // Primera entrada con ese hash (búsqueda binaria)
+        uint64_t lo = 0, hi = pair_count;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (fuzzy_index.pairs[mid].hash < hash) lo = mid + 1;
+            else hi = mid;
+        }
+        
+        for (; lo < pair_count && fuzzy_index.pairs[lo].hash == hash &&
+               candidate_count < FUZZY_MAX_CANDIDATES; lo++) {
+            fuzzy_candidates[candidate_count++] = fuzzy_index.pairs[lo].name_id;
+        }
+    }
+    
+    qsort(fuzzy_candidates, candidate_count, sizeof(uint32_t), compare_uint32);
+    
+    size_t query_length = strlen(lower_query);
+    int match_count = 0;
+    for (int c = 0; c < candidate_count; c++) {
+        if (c > 0 && fuzzy_candidates[c] == fuzzy_candidates[c - 1]) continue;
+        
+        const FuzzyName *name = &fuzzy_index.names[fuzzy_candidates[c]];
+        int distance = bounded_edit_distance(lower_query, query_length,
+                                             fuzzy_index.heap + name->text_offset, name->length,
+                                             FUZZY_MAX_EDITS);
+        if (distance >= 0) {
+            fuzzy_matches[match_count].name_id = fuzzy_candidates[c];
+            fuzzy_matches[match_count].distance = distance;
+            match_count++;
+        }
+    }
+    
+    qsort(fuzzy_matches, match_count, sizeof(FuzzyMatch), compare_fuzzy_matches);
+    return match_count;
+}
+
+// Función para búsqueda aproximada por nombre (hasta 2 errores)
+int search_by_fuzzy_name(const char *filename, const char *name, Song *results, int max_results,
+                         TopK *topk) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) return 0;
+    
+    char lower_query[MAX_TITLE];
+    to_lower_copy(lower_query, name, sizeof(lower_query));
+    int found = 0;
+    
+    if (fuzzy_index.map) {
+        uint64_t trace_start = trace_now();
+        int match_count = fuzzy_lookup(lower_query);
+        trace_span("index_lookup", trace_start);
+        
+        trace_start = trace_now();
+        for (int m = 0; m < match_count && (topk || found < max_results); m++) {
+            const FuzzyName *match = &fuzzy_index.names[fuzzy_matches[m].name_id];
+            for (uint32_t p = 0; p < match->count && (topk || found < max_results); p++) {
+                Song song;
+                if (!read_song(file, fuzzy_index.positions[match->first_position + p], &song)) break;
+                if (topk) topk_push(topk, &song);
+                else results[found++] = song;
+            }
+        }
+        trace_span("scan", trace_start);
+        
+        fclose(file);
+        return found;
+    }
+    
+    // Sin índice: distancia de edición contra cada registro
+    SongCursor cursor;
+    if (!cursor_open(&cursor, file)) {
+        fclose(file);
+        return 0;
+    }
+    
+    uint64_t trace_start = trace_now();
+    size_t query_length = strlen(lower_query);
+    Song *song;
+    while ((topk || found < max_results) && (song = cursor_next(&cursor)) != NULL) {
+        char lower_name[MAX_TITLE];
+        to_lower_copy(lower_name, song->name, sizeof(lower_name));
+        if (bounded_edit_distance(lower_query, query_length, lower_name, strlen(lower_name),
+                                  FUZZY_MAX_EDITS) >= 0) {
+            if (topk) topk_push(topk, song);
+            else results[found++] = *song;
+        }
+    }
+    trace_span("scan", trace_start);
+    
+    fclose(file);
+    return found;
+}
+
+// Mapear el índice de vectores si corresponde a la base actual
+int vector_load(VectorIndex *index, const char *vec_filename, long record_count) {
+    memset(index, 0, sizeof(VectorIndex));
+    
+    int fd = open(vec_filename, O_RDONLY);
+    if (fd == -1) return 0;
+    
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(VecHeader)) {
+        close(fd);
+        return 0;
+    }
+    
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+    
+    const VecHeader *header = map;
+    size_t expected = sizeof(VecHeader) +
+                      (sizeof(VecIdEntry) + VEC_DIMS) * header->record_count;
+    if (header->magic != VEC_MAGIC || header->dims != VEC_DIMS ||
+        header->record_count != (uint64_t)record_count || expected != (size_t)st.st_size) {
+        printf("Aviso: índice %s ausente o desactualizado, se ignora\n", vec_filename);
+        munmap(map, st.st_size);
+        return 0;
+    }
+    
+    index->map = map;
+    index->map_size = st.st_size;
+    index->header = header;
+    index->ids = (const VecIdEntry*)(header + 1);
+    index->codes = (const uint8_t*)(index->ids + header->record_count);
+    return 1;
+}
+
+// Hash de 64 bits (FNV-1a) del identificador, sin normalizar
+uint64_t id_hash64(const char *id) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    while (*id) {
+        hash ^= (unsigned char)*id++;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Vector de características (igual que creador), normalizado a [0, 255]
+void song_normalized_features(const Song *song, float *features) {
+    const VecHeader *header = vector_index.header;
+    float raw[VEC_DIMS];
+    raw[0] = (float)song->danceability;
+    raw[1] = (float)song->energy;
+    raw[2] = (float)song->tempo;
+    raw[3] = logf(song->duration_ms > 1000 ? (float)song->duration_ms : 1000.0f);
+    
+    for (int d = 0; d < VEC_DIMS; d++) {
+        features[d] = (raw[d] - header->min[d]) * header->scale[d];
+    }
+}
+
+// Distancias euclídeas al cuadrado entre la consulta y "count" vectores
+// cuantizados; con SSE2 se procesan cuatro canciones por iteración
+void knn_distances(const uint8_t *codes, size_t count, const uint8_t *query, uint32_t *out) {
+    size_t i = 0;
+    
+#ifdef __SSE2__
+    __m128i zero = _mm_setzero_si128();
+    __m128i q = _mm_set_epi16(query[3], query[2], query[1], query[0],
+                              query[3], query[2], query[1], query[0]);
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(codes + i * VEC_DIMS));
+        __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(v, zero), q); // Canciones i, i+1
+        __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(v, zero), q); // Canciones i+2, i+3
+        __m128 a = _mm_castsi128_ps(_mm_madd_epi16(lo, lo));
+        __m128 b = _mm_castsi128_ps(_mm_madd_epi16(hi, hi));
+        __m128i even = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i odd = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_add_epi32(even, odd));
+    }
+#endif
+    
+    for (; i < count; i++) {
+        uint32_t sum = 0;
+        for (int d = 0; d < VEC_DIMS; d++) {
+            int diff = (int)codes[i * VEC_DIMS + d] - (int)query[d];
+            sum += (uint32_t)(diff * diff);
+        }
+        out[i] = sum;
+    }
+}
+
+// Montículo de máximos sobre la distancia: la raíz es el peor candidato
+void knn_push(KnnCandidate *heap, int *count, int capacity, float distance, uint32_t row) {
+    int i;
+    if (*count < capacity) {
+        i = (*count)++;
+        while (i > 0 && heap[(i - 1) / 2].distance < distance) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+    } else if (distance < heap[0].distance) {
+        i = 0;
+        while (1) {
+            int child = 2 * i + 1;
+            if (child >= *count) break;
+            if (child + 1 < *count && heap[child + 1].distance > heap[child].distance) child++;
+            if (heap[child].distance <= distance) break;
+            heap[i] = heap[child];
+            i = child;
+        }
+    } else {
+        return;
+    }
+    heap[i].distance = distance;
+    heap[i].row = row;
+}
+
+int compare_knn_candidates(const void *a, const void *b) {
+    const KnnCandidate *ca = a, *cb = b;
+    if (ca->distance != cb->distance) return ca->distance < cb->distance ? -1 : 1;
+    return ca->row < cb->row ? -1 : (ca->row > cb->row);
+}
+
+// Fila del índice de vectores para un identificador, o -1
+long knn_find_row(FILE *file, const char *id) {
+    uint64_t hash = id_hash64(id);
+    uint64_t lo = 0, hi = vector_index.header->record_count;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (vector_index.ids[mid].hash < hash) lo = mid + 1;
+        else hi = mid;
+    }
+    
+    // Confirmar contra el registro por si dos identificadores comparten hash
+    for (; lo < vector_index.header->record_count && vector_index.ids[lo].hash == hash; lo++) {
+        long row = (long)vector_index.ids[lo].row;
+        Song song;
+        if (read_song(file, (long)(sizeof(HashEntry) * HASH_SIZE) + row * (long)sizeof(SongRecord), &song) &&
+            strcmp(song.id, id) == 0) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+// Función para buscar las k canciones más parecidas a una dada (por ID)
+int search_similar_songs(const char *filename, const char *id, Song *results, int max_results) {
+    if (!vector_index.map) {
+        printf("Índice de vectores no disponible: ejecute 'creador -k'\n");
+        return 0;
+    }
+    
+    FILE *file = fopen(filename, "rb");
+    if (!file) return 0;
+    
+    uint64_t trace_start = trace_now();
+    long query_row = knn_find_row(file, id);
+    trace_span("index_lookup", trace_start);
+    if (query_row < 0) {
+        fclose(file);
+        return 0;
+    }
+    
+    // Primera pasada sobre los códigos: candidatos por distancia cuantizada
+    trace_start = trace_now();
+    KnnCandidate candidates[KNN_MAX_CANDIDATES];
+    int capacity = max_results * KNN_RERANK;
+    if (capacity > KNN_MAX_CANDIDATES) capacity = KNN_MAX_CANDIDATES;
+    int candidate_count = 0;
+    
+    const uint8_t *query = vector_index.codes + query_row * VEC_DIMS;
+    uint32_t distances[KNN_BLOCK];
+    size_t total = vector_index.header->record_count;
+    for (size_t start = 0; start < total; start += KNN_BLOCK) {
+        size_t count = total - start < KNN_BLOCK ? total - start : KNN_BLOCK;
+        knn_distances(vector_index.codes + start * VEC_DIMS, count, query, distances);
+        
+        for (size_t i = 0; i < count; i++) {
+            if ((long)(start + i) == query_row) continue;
+            if (candidate_count == capacity && distances[i] >= candidates[0].distance) continue;
+            knn_push(candidates, &candidate_count, capacity, (float)distances[i], (uint32_t)(start + i));
+        }
+    }
+    g_query.bytes_read += total * VEC_DIMS;
+    
+    // Reordenar los candidatos con los valores exactos de cada registro
+    Song query_song;
+    float query_features[VEC_DIMS];
+    read_song(file, (long)(sizeof(HashEntry) * HASH_SIZE) + query_row * (long)sizeof(SongRecord), &query_song);
+    song_normalized_features(&query_song, query_features);
+    
+    for (int c = 0; c < candidate_count; c++) {
+        Song song;
+        float features[VEC_DIMS];
+        float distance = 0.0f;
+        long position = (long)(sizeof(HashEntry) * HASH_SIZE) + (long)candidates[c].row * (long)sizeof(SongRecord);
+        if (!read_song(file, position, &song)) continue;
+        
+        song_normalized_features(&song, features);
+        for (int d = 0; d < VEC_DIMS; d++) {
+            distance += (features[d] - query_features[d]) * (features[d] - query_features[d]);
+        }
+        candidates[c].distance = distance;
+    }
+    qsort(candidates, candidate_count, sizeof(KnnCandidate), compare_knn_candidates);
+    
+    int found = 0;
+    for (int c = 0; c < candidate_count && found < max_results; c++) {
+        long position = (long)(sizeof(HashEntry) * HASH_SIZE) + (long)candidates[c].row * (long)sizeof(SongRecord);
+        if (read_song(file, position, &results[found])) found++;
+    }
+    trace_span("scan", trace_start);
+    
+    fclose(file);
+    return found;
+}
+
+// Mapear el índice de autocompletado si corresponde a la base actual
+int complete_load(CompleteIndex *index, const char *complete_filename, long record_count) {
+    memset(index, 0, sizeof(CompleteIndex));
+    
+    int fd = open(complete_filename, O_RDONLY);
+    if (fd == -1) return 0;
+    
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(CompleteHeader)) {
+        close(fd);
+        return 0;
+    }
+    
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+    
+    const CompleteHeader *header = map;
+    size_t expected = sizeof(CompleteHeader) + sizeof(CompleteEntry) * header->entry_count +
+                      sizeof(CompleteHot) * header->hot_count + header->heap_size;
+    if (header->magic != COMPLETE_MAGIC || header->top != COMPLETE_TOP ||
+        header->record_count != (uint64_t)record_count || expected != (size_t)st.st_size) {
+        printf("Aviso: índice %s ausente o desactualizado, se ignora\n", complete_filename);
+        munmap(map, st.st_size);
+        return 0;
+    }
+    
+    index->map = map;
+    index->map_size = st.st_size;
+    index->header = header;
+    index->entries = (const CompleteEntry*)(header + 1);
+    index->hot = (const CompleteHot*)(index->entries + header->entry_count);
+    index->heap = (const char*)(index->hot + header->hot_count);
+    return 1;
+}
+
+// Comparar un término con el prefijo (en minúsculas): 0 si empieza por él
+int complete_compare(const CompleteEntry *entry, const char *prefix, size_t length) {
+    const char *text = complete_index.heap + entry->text_offset;
+    for (size_t i = 0; i < length; i++) {
+        if (i == entry->length) return -1;
+        int c = tolower((unsigned char)text[i]);
+        if (c != (unsigned char)prefix[i]) return c - (unsigned char)prefix[i];
+    }
+    return 0;
+}
+
+// Orden de sugerencias: más canciones, luego más reciente, luego alfabético
+int complete_better(uint32_t a, uint32_t b) {
+    const CompleteEntry *entries = complete_index.entries;
+    if (entries[a].count != entries[b].count) return entries[a].count > entries[b].count;
+    if (entries[a].year != entries[b].year) return entries[a].year > entries[b].year;
+    return a < b;
+}
+
+// Mejores "limit" términos que empiezan por el prefijo (en minúsculas)
+int complete_lookup(const char *prefix, int limit, uint32_t *top) {
+    size_t length = strlen(prefix);
+    
+    // Prefijos cortos y frecuentes: sugerencias precalculadas
+    if (length <= COMPLETE_HOT_PREFIX) {
+        uint64_t lo = 0, hi = complete_index.header->hot_count;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            int cmp = strcmp(complete_index.hot[mid].prefix, prefix);
+            if (cmp == 0) {
+                int found = 0;
+                while (found < limit && complete_index.hot[mid].top[found] != UINT32_MAX) {
+                    top[found] = complete_index.hot[mid].top[found];
+                    found++;
+                }
+                g_query.prefix_hits++;
+                return found;
+            }
+            if (cmp < 0) lo = mid + 1;
+            else hi = mid;
+        }
+    }
+    
+    // Rango de términos con el prefijo: [first, last)
+    uint64_t lo = 0, hi = complete_index.header->entry_count;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (complete_compare(&complete_index.entries[mid], prefix, length) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    uint64_t first = lo;
+    hi = complete_index.header->entry_count;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (complete_compare(&complete_index.entries[mid], prefix, length) <= 0) lo = mid + 1;
+        else hi = mid;
+    }
+    uint64_t last = lo;
+    
+    // Selección por inserción de los mejores del rango
+    int found = 0;
+    for (uint64_t k = first; k < last; k++) {
+        if (found == limit && !complete_better((uint32_t)k, top[found - 1])) continue;
+        int pos = found < limit ? found++ : limit - 1;
+        while (pos > 0 && complete_better((uint32_t)k, top[pos - 1])) {
+            top[pos] = top[pos - 1];
+            pos--;
+        }
+        top[pos] = (uint32_t)k;
+    }
+    g_query.records_scanned += last - first;
+    return found;
+}
+
+// Función para autocompletar nombres de canciones y artistas por prefijo.
+// Cada sugerencia se devuelve como una canción: name = término, id = tipo,
+// duration_ms = canciones con el término, year = año más reciente
+int search_completions(const char *prefix, Song *results, int max_results) {
+    if (!complete_index.map) {
+        printf("Índice de autocompletado no disponible: ejecute 'creador -a'\n");
+        return 0;
+    }
+    
+    char lower_prefix[MAX_TITLE];
+    to_lower_copy(lower_prefix, prefix, sizeof(lower_prefix));
+    if (lower_prefix[0] == '\0') return 0;
+    
+    uint64_t trace_start = trace_now();
+    uint32_t top[COMPLETE_TOP];
+    int limit = max_results < COMPLETE_TOP ? max_results : COMPLETE_TOP;
+    int found = complete_lookup(lower_prefix, limit, top);
+    trace_span("index_lookup", trace_start);
+    
+    for (int i = 0; i < found; i++) {
+        const CompleteEntry *entry = &complete_index.entries[top[i]];
+        Song *song = &results[i];
+        memset(song, 0, sizeof(Song));
+        snprintf(song->id, sizeof(song->id), "%s",
+                 entry->kind == COMPLETE_KIND_ARTIST ? "artista" : "canción");
+        snprintf(song->name, sizeof(song->name), "%s", complete_index.heap + entry->text_offset);
+        song->duration_ms = (int)entry->count;
+        song->year = entry->year;
+    }
+    return found;
+}
+
+// Mapear el archivo de columnas si corresponde a la base actual
+int column_store_load(ColumnStore *store, const char *col_filename, long record_count) {
+    store->map = NULL;
+    store->cached_block = -1;
+    
+    int fd = open(col_filename, O_RDONLY);
+    if (fd == -1) return 0;
+    
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(ColumnHeader)) {
+        close(fd);
+        return 0;
+    }
+    
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+    
+    const ColumnHeader *header = map;
+    size_t rows = header->record_count;
+    size_t expected = sizeof(ColumnHeader) +
+                      sizeof(ColumnString) * (header->artist_count + header->album_count) +
+                      sizeof(ColumnBlock) * header->block_count +
+                      (sizeof(uint32_t) * 2 + sizeof(int32_t) + sizeof(float) * 3 + sizeof(int16_t)) * rows +
+                      header->heap_size;
+    if (header->magic != COL_MAGIC || header->record_count != (uint64_t)record_count ||
+        expected != (size_t)st.st_size) {
+        munmap(map, st.st_size);
+        return 0;
+    }
+    
+    store->map = map;
+    store->map_size = st.st_size;
+    store->header = header;
+    store->artists = (const ColumnString*)(header + 1);
+    store->albums = store->artists + header->artist_count;
+    store->blocks = (const ColumnBlock*)(store->albums + header->album_count);
+    store->artist_ids = (const uint32_t*)(store->blocks + header->block_count);
+    store->album_ids = store->artist_ids + rows;
+    store->durations = (const int32_t*)(store->album_ids + rows);
+    store->danceability = (const float*)(store->durations + rows);
+    store->energy = store->danceability + rows;
+    store->tempo = store->energy + rows;
+    store->years = (const int16_t*)(store->tempo + rows);
+    store->heap = (const uint8_t*)(store->years + rows);
+    
+    // Cada texto debe caer dentro de un bloque que quepa en block_buffer
+    int ok = 1;
+    for (uint64_t b = 0; ok && b < header->block_count; b++) {
+        const ColumnBlock *block = &store->blocks[b];
+        ok = block->raw_size <= COL_BLOCK_SIZE && block->stored_size <= block->raw_size &&
+             block->offset + block->stored_size <= header->heap_size;
+    }
+    for (uint64_t i = 0; ok && i < header->artist_count + header->album_count; i++) {
+        const ColumnString *entry = &store->artists[i];
+        ok = entry->block < header->block_count &&
+             entry->offset + entry->length <= store->blocks[entry->block].raw_size;
+    }
+    if (!ok) {
+        munmap(map, st.st_size);
+        store->map = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+// Descompresor de bloque en formato LZ4; devuelve los bytes escritos o -1
+int lz4_decompress_block(const uint8_t *src, int src_size, uint8_t *dst, int dst_size) {
+    int ip = 0, op = 0;
+    
+    while (ip < src_size) {
+        int token = src[ip++];
+        int literals = token >> 4;
+        if (literals == 15) {
+            int b;
+            do {
+                if (ip >= src_size) return -1;
+                b = src[ip++];
+                literals += b;
+            } while (b == 255);
+        }
+        if (ip + literals > src_size || op + literals > dst_size) return -1;
+        memcpy(dst + op, src + ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip >= src_size) break; // La última secuencia solo tiene literales
+        
+        if (ip + 2 > src_size) return -1;
+        int offset = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) return -1;
+        
+        int match = token & 15;
+        if (match == 15) {
+            int b;
+            do {
+                if (ip >= src_size) return -1;
+                b = src[ip++];
+                match += b;
+            } while (b == 255);
+        }
+        match += LZ4_MIN_MATCH;
+        if (op + match > dst_size) return -1;
+        
+        // Copia byte a byte: la coincidencia puede solaparse con lo que escribe
+        for (int i = 0; i < match; i++, op++) {
+            dst[op] = dst[op - offset];
+        }
+    }
+    return op;
+}
+
+// Bloque de texto descomprimido: los bloques sin comprimir se leen directo
+// del mapeo; los comprimidos se descomprimen al pedirlos y se guarda el último
+const uint8_t *column_block(ColumnStore *store, long block) {
+    const ColumnBlock *info = &store->blocks[block];
+    if (info->stored_size == info->raw_size) {
+        return store->heap + info->offset;
+    }
+    if (store->cached_block == block) {
+        g_query.block_hits++;
+        return store->block_buffer;
+    }
+    
+    int size = lz4_decompress_block(store->heap + info->offset, (int)info->stored_size,
+                                    store->block_buffer, COL_BLOCK_SIZE);
+    g_query.bytes_read += info->stored_size;
+    if (size != (int)info->raw_size) {
+        store->cached_block = -1;
+        return NULL;
+    }
+    store->cached_block = block;
+    return store->block_buffer;
+}
+
+// Copiar un texto del diccionario (terminado en '\0'); 0 si el bloque está dañado
+int column_string(ColumnStore *store, const ColumnString *entry, char *dest, size_t size) {
+    const uint8_t *block = column_block(store, entry->block);
+    if (!block) return 0;
+    
+    size_t length = entry->length < size - 1 ? entry->length : size - 1;
+    memcpy(dest, block + entry->offset, length);
+    dest[length] = '\0';
+    return 1;
+}
+
+// Copiar del diccionario el álbum y los artistas de las canciones que se
+// devuelven ("?" si el identificador o el bloque de texto están dañados)
+void songs_load_texts(Song *songs, int count) {
+    const ColumnHeader *header = column_store.header;
+    for (int i = 0; i < count; i++) {
+        Song *song = &songs[i];
+        if (song->artist_id >= header->artist_count ||
+            !column_string(&column_store, &column_store.artists[song->artist_id],
+                           song->artists, sizeof(song->artists))) {
+            strcpy(song->artists, "?");
+        }
+        if (song->album_id >= header->album_count ||
+            !column_string(&column_store, &column_store.albums[song->album_id],
+                           song->album, sizeof(song->album))) {
+            strcpy(song->album, "?");
+        }
+    }
+}
+
+// Artistas del diccionario que contienen cada patrón (en minúsculas): un
+// bit por identificador en sets[p]. Una sola pasada por el texto para todos
+// los patrones, así cada artista distinto se pasa a minúsculas una vez.
+// 0 si falta memoria o el diccionario está dañado
+int artist_match_sets(const char *const *patterns, int count, uint64_t **sets) {
+    uint64_t artist_count = column_store.header->artist_count;
+    size_t words = artist_count / 64 + 1;
+    int ok = 1;
+    for (int p = 0; p < count; p++) {
+        sets[p] = calloc(words, sizeof(uint64_t));
+        if (!sets[p]) ok = 0;
+    }
+    
+    for (uint64_t a = 0; ok && a < artist_count; a++) {
+        char text[MAX_ARTIST];
+        char lower_text[MAX_ARTIST];
+        if (!column_string(&column_store, &column_store.artists[a], text, sizeof(text))) {
+            ok = 0;
+            break;
+        }
+        to_lower_copy(lower_text, text, sizeof(lower_text));
+        for (int p = 0; p < count; p++) {
+            if (strstr(lower_text, patterns[p]) != NULL) sets[p][a / 64] |= 1ull << (a % 64);
+        }
+    }
+    g_query.bytes_read += sizeof(ColumnString) * artist_count;
+    
+    if (!ok) {
+        for (int p = 0; p < count; p++) {
+            free(sets[p]);
+            sets[p] = NULL;
+        }
+    }
+    return ok;
+}
+
+// 1 si el artista está en el conjunto de artist_match_sets
+int artist_in_set(const uint64_t *set, uint32_t artist_id) {
+    return artist_id < column_store.header->artist_count &&
+           (set[artist_id / 64] >> (artist_id % 64)) & 1;
+}
+
+// Búsqueda por artista sobre las columnas: recorre la columna de
+// identificadores y solo lee los registros que coinciden, en orden de
+// archivo (el mismo del recorrido en una base agrupada)
+int search_artist_by_columns(FILE *file, const uint64_t *matches, Song *results,
+                             int max_results, TopK *topk) {
+    int found = 0;
+    uint64_t rows = column_store.header->record_count;
+    for (uint64_t row = 0; row < rows && (topk || found < max_results); row++) {
+        if (!artist_in_set(matches, column_store.artist_ids[row])) continue;
+        
+        Song song;
+        long position = (long)(sizeof(HashEntry) * HASH_SIZE) + (long)row * (long)sizeof(SongRecord);
+        if (!read_song(file, position, &song)) break;
+        if (topk) topk_push(topk, &song);
+        else results[found++] = song;
+    }
+    g_query.bytes_read += sizeof(uint32_t) * rows;
+    return found;
+}
+
+// Función para buscar por nombre exacto
+int search_by_exact_name(const char *filename, const char *name, Song *results, int max_results,
+                         TopK *topk) {
+    // Los nombres que no están en el catálogo se responden sin E/S
+    if (name_bloom.blocks && !bloom_may_contain(&name_bloom, name)) {
+        g_query.filter_rejects++;
+        return 0;
+    }
+    
+    FILE *file = fopen(filename, "rb");
+    if (!file) return 0;
+    
+    uint64_t trace_start = trace_now();
+    
+    // Con índice MPH: una ranura y una lectura de registro por coincidencia.
+    // Con ORDER BY se leen todos los duplicados, por tramos, para que el
+    // montículo elija entre todos y no solo entre los primeros de la cadena
+    if (name_mph.file) {
+        MphSlot slot;
+        int matched = mph_find(&name_mph, name, &slot);
+        trace_span("index_lookup", trace_start);
+        
+        trace_start = trace_now();
+        long positions[MAX_RESULTS];
+        uint32_t first = 0;
+        int found = 0;
+        while (matched && (topk || found < max_results)) {
+            int wanted = topk ? MAX_RESULTS : max_results - found;
+            int candidates = mph_positions(&name_mph, &slot, first, positions, wanted);
+            if (candidates == 0) break;
+            first += candidates;
+            
+            for (int i = 0; i < candidates && (topk || found < max_results); i++) {
+                Song song;
+                if (!read_song(file, positions[i], &song)) break;
+                if (strcasecmp(song.name, name) == 0) {
+                    if (topk) topk_push(topk, &song);
+                    else results[found++] = song;
+                }
+            }
+        }
+        trace_span("scan", trace_start);
+        
+        fclose(file);
+        return found;
+    }
+    
+    // Base agrupada: el bucket es un único tramo contiguo
+    if (bucket_dir.loaded) {
+        BucketRun run = bucket_dir.runs[hash_function(name)];
+        trace_span("index_lookup", trace_start);
+        
+        trace_start = trace_now();
+        Song batch[SCAN_BATCH];
+        int found = 0;
+        while (run.count > 0 && (topk || found < max_results)) {
+            int wanted = run.count < SCAN_BATCH ? (int)run.count : SCAN_BATCH;
+            int read_count = read_songs(file, run.offset, batch, wanted);
+            if (read_count == 0) break;
+            g_query.chain_links += read_count;
+            
+            for (int i = 0; i < read_count && (topk || found < max_results); i++) {
+                if (strcasecmp(batch[i].name, name) == 0) {
+                    if (topk) topk_push(topk, &batch[i]);
+                    else results[found++] = batch[i];
+                }
+            }
+            run.offset += (long)sizeof(SongRecord) * read_count;
+            run.count -= read_count;
+        }
+        trace_span("scan", trace_start);
+        
+        fclose(file);
+        return found;
+    }
     
     HashEntry hash_table[HASH_SIZE];
-    if (fread(hash_table, sizeof(HashEntry), HASH_SIZE, file) != HASH_SIZE) {
+    if (!read_hash_table(file, hash_table)) {
+        fclose(file);
+        return 0;
+    }
+    
+    int hash_index = hash_function(name);
+    long current_pos = hash_table[hash_index].first_position;
+    int found = 0;
+    trace_span("index_lookup", trace_start);
+    
+    trace_start = trace_now();
+    while (current_pos != -1 && (topk || found < max_results)) {
+        Song song;
+        if (!read_song(file, current_pos, &song)) break;
+        g_query.chain_links++;
+        
+        if (strcasecmp(song.name, name) == 0) {
+            if (topk) topk_push(topk, &song);
+            else results[found++] = song;
+        }
+        
+        current_pos = song.next;
+    }
+    trace_span("scan", trace_start);
+    
+    fclose(file);
+    return found;
+}
+
+// Función para buscar por palabra en el nombre
+int search_by_name_word(const char *filename, const char *word, Song *results, int max_results,
+                        TopK *topk) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) return 0;
+    
+    uint64_t trace_start = trace_now();
+    SongCursor cursor;
+    if (!cursor_open(&cursor, file)) {
+        fclose(file);
+        return 0;
+    }
+    trace_span("index_lookup", trace_start);
+    
+    int found = 0;
+    char lower_word[MAX_TITLE];
+    strncpy(lower_word, word, sizeof(lower_word) - 1);
+    lower_word[sizeof(lower_word) - 1] = '\0';
+    for (int i = 0; lower_word[i]; i++) {
+        lower_word[i] = tolower(lower_word[i]);
+    }
+    
+    trace_start = trace_now();
+    Song *song;
+    while ((topk || found < max_results) && (song = cursor_next(&cursor)) != NULL) {
+        char lower_name[MAX_TITLE];
+        strncpy(lower_name, song->name, sizeof(lower_name) - 1);
+        lower_name[sizeof(lower_name) - 1] = '\0';
+        for (int j = 0; lower_name[j]; j++) {
+            lower_name[j] = tolower(lower_name[j]);
+        }
+        
+        if (strstr(lower_name, lower_word) != NULL) {
+            if (topk) topk_push(topk, song);
+            else results[found++] = *song;
+        }
+    }
+    trace_span("scan", trace_start);
+    
+    fclose(file);
+    return found;
+}
+
+// Función para buscar por artista. El patrón se evalúa una vez por artista
+// distinto del diccionario y cada registro se decide por su identificador
+int search_by_artist(const char *filename, const char *artist, Song *results, int max_results,
+                     TopK *topk) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) return 0;
+    
+    char lower_artist[MAX_ARTIST];
+    to_lower_copy(lower_artist, artist, sizeof(lower_artist));
+    
+    uint64_t trace_start = trace_now();
+    const char *patterns[1] = {lower_artist};
+    uint64_t *matches;
+    SongCursor cursor;
+    if (!artist_match_sets(patterns, 1, &matches)) {
+        fclose(file);
+        return 0;
+    }
+    
+    // En una base agrupada (creador -c) el orden físico es el del recorrido,
+    // así que basta la columna de identificadores
+    if (bucket_dir.loaded) {
+        trace_span("index_lookup", trace_start);
+        trace_start = trace_now();
+        int found = search_artist_by_columns(file, matches, results, max_results, topk);
+        trace_span("scan", trace_start);
+        free(matches);
+        fclose(file);
+        return found;
+    }
+    
+    if (!cursor_open(&cursor, file)) {
+        free(matches);
+        fclose(file);
+        return 0;
+    }
+    trace_span("index_lookup", trace_start);
+    
+    trace_start = trace_now();
+    int found = 0;
+    Song *song;
+    while ((topk || found < max_results) && (song = cursor_next(&cursor)) != NULL) {
+        if (artist_in_set(matches, song->artist_id)) {
+            if (topk) topk_push(topk, song);
+            else results[found++] = *song;
+        }
+    }
+    trace_span("scan", trace_start);
+    
+    free(matches);
+    fclose(file);
+    return found;
+}
+
+// Función para buscar por año
+int search_by_year(const char *filename, int year, Song *results, int max_results,
+                   TopK *topk) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) return 0;
+    
+    uint64_t trace_start = trace_now();
+    SongCursor cursor;
+    if (!cursor_open(&cursor, file)) {
         fclose(file);
         return 0;
     }
+    trace_span("index_lookup", trace_start);
+    
+    int found = 0;
+    
+    trace_start = trace_now();
+    Song *song;
+    while ((topk || found < max_results) && (song = cursor_next(&cursor)) != NULL) {
+        if (song->year == year) {
+            if (topk) topk_push(topk, song);
+            else results[found++] = *song;
+        }
+    }
+    trace_span("scan", trace_start);
+    
+    fclose(file);
+    return found;
+}
+
+// Función para mostrar estadísticas
+int get_database_stats(const char *filename, int *total_songs, int *min_year, int *max_year) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) return -1;
+    
+    SongCursor cursor;
+    if (!cursor_open(&cursor, file)) {
+        fclose(file);
+        return -1;
+    }
+    
+    *total_songs = 0;
+    *min_year = 3000;
+    *max_year = 0;
+    
+    Song *song;
+    while ((song = cursor_next(&cursor)) != NULL) {
+        (*total_songs)++;
+        if (song->year < *min_year) *min_year = song->year;
+        if (song->year > *max_year) *max_year = song->year;
+    }
+    
+    fclose(file);
+    return 0;
+}
+
+// Grupos posibles de cada agrupación: claves de la tabla densa (por artista, las del diccionario)
+uint64_t aggregate_group_capacity(int group_by) {
+    switch (group_by) {
+        case AGG_BY_YEAR: return AGG_MAX_YEAR;
+        case AGG_BY_DECADE: return (AGG_MAX_YEAR + 9) / 10;
+        case AGG_BY_ARTIST: return column_store.header->artist_count;
+        default: return 1;
+    }
+}
+
+void aggregate_cells_init(AggregateCell *cells, uint64_t count) {
+    for (uint64_t i = 0; i < count; i++) {
+        cells[i].count = 0;
+        cells[i].sum = 0.0;
+        cells[i].min = INFINITY;
+        cells[i].max = -INFINITY;
+    }
+}
+
+void aggregate_add(AggregateCell *cell, double value) {
+    cell->count++;
+    cell->sum += value;
+    if (value < cell->min) cell->min = value;
+    if (value > cell->max) cell->max = value;
+}
+
+void aggregate_merge(AggregateCell *dst, const AggregateCell *src) {
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+double aggregate_value(const AggregateSpec *spec, const AggregateCell *cell) {
+    switch (spec->function) {
+        case AGG_SUM: return cell->sum;
+        case AGG_AVG: return cell->sum / cell->count;
+        case AGG_MIN: return cell->min;
+        case AGG_MAX: return cell->max;
+        default: return (double)cell->count;
+    }
+}
+
+// Acumular un bloque entero en un solo grupo. Con SSE2 se procesan cuatro
+// valores por iteración: suma en doble precisión, mínimo y máximo en float
+void aggregate_block(const float *values, int count, AggregateCell *cell) {
+    int i = 0;
+#ifdef __SSE2__
+    __m128d sum_low = _mm_setzero_pd();
+    __m128d sum_high = _mm_setzero_pd();
+    __m128 low = _mm_set1_ps(INFINITY);
+    __m128 high = _mm_set1_ps(-INFINITY);
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_loadu_ps(values + i);
+        sum_low = _mm_add_pd(sum_low, _mm_cvtps_pd(v));
+        sum_high = _mm_add_pd(sum_high, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+        low = _mm_min_ps(low, v);
+        high = _mm_max_ps(high, v);
+    }
+    
+    double sums[2];
+    float lows[4], highs[4];
+    _mm_storeu_pd(sums, _mm_add_pd(sum_low, sum_high));
+    _mm_storeu_ps(lows, low);
+    _mm_storeu_ps(highs, high);
+    cell->count += i;
+    cell->sum += sums[0] + sums[1];
+    for (int k = 0; k < 4; k++) {
+        if (lows[k] < cell->min) cell->min = lows[k];
+        if (highs[k] > cell->max) cell->max = highs[k];
+    }
+#endif
+    for (; i < count; i++) {
+        aggregate_add(cell, values[i]);
+    }
+}
+
+// Valores del campo para las filas [first, first + count). Las columnas float
+// se usan directamente del mapeo; duración y año se convierten (las duraciones
+// son exactas en float hasta 2^24 ms, unas 4,6 horas)
+const float *aggregate_values(int field, uint64_t first, int count, float *buffer) {
+    switch (field) {
+        case ORDER_ENERGY: return column_store.energy + first;
+        case ORDER_DANCEABILITY: return column_store.danceability + first;
+        case ORDER_TEMPO: return column_store.tempo + first;
+        case ORDER_DURATION:
+            for (int i = 0; i < count; i++) buffer[i] = (float)column_store.durations[first + i];
+            return buffer;
+        default:
+            for (int i = 0; i < count; i++) buffer[i] = column_store.years[first + i];
+            return buffer;
+    }
+}
+
+// Orden de los grupos por artista: mayor valor primero, luego más canciones y por último
+// el texto (los identificadores del diccionario ya siguen el orden de strcmp)
+int compare_aggregate_groups(const void *a, const void *b) {
+    const AggregateGroup *ga = a, *gb = b;
+    if (ga->value != gb->value) return ga->value > gb->value ? -1 : 1;
+    if (ga->count != gb->count) return ga->count > gb->count ? -1 : 1;
+    return ga->key < gb->key ? -1 : (ga->key > gb->key);
+}
+
+// Hilo de agregación: recorre su rango de filas por bloques y acumula en su
+// propia tabla los grupos con clave en [key_first, key_first + group_count),
+// sin compartir nada con los demás hilos
+void *aggregate_worker(void *arg) {
+    AggregateTask *task = arg;
+    const AggregateSpec *spec = task->spec;
+    float buffer[AGG_BLOCK];
+    uint32_t year_keys[AGG_BLOCK];
     
-    int found = 0;
-    char lower_word[MAX_TITLE];
-    strncpy(lower_word, word, sizeof(lower_word) - 1);
-    lower_word[sizeof(lower_word) - 1] = '\0';
-    for (int i = 0; lower_word[i]; i++) {
-        lower_word[i] = tolower(lower_word[i]);
+    for (uint64_t first = task->first; first < task->last; first += AGG_BLOCK) {
+        int count = task->last - first < AGG_BLOCK ? (int)(task->last - first) : AGG_BLOCK;
+        const float *values = spec->function == AGG_COUNT ? NULL :
+                              aggregate_values(spec->field, first, count, buffer);
+        
+        if (spec->group_by == AGG_BY_TOTAL) {
+            if (values) aggregate_block(values, count, &task->cells[0]);
+            else task->cells[0].count += count;
+            continue;
+        }
+        
+        // Clave de grupo de cada fila; los años fuera de rango quedan fuera de la tabla
+        const uint32_t *keys = year_keys;
+        const int16_t *years = column_store.years + first;
+        if (spec->group_by == AGG_BY_ARTIST) {
+            keys = column_store.artist_ids + first;
+        } else {
+            int divisor = spec->group_by == AGG_BY_DECADE ? 10 : 1;
+            for (int i = 0; i < count; i++) {
+                year_keys[i] = years[i] >= 0 && years[i] < AGG_MAX_YEAR ?
+                               (uint32_t)years[i] / divisor : UINT32_MAX;
+            }
+        }
+        
+        // Con grupo la acumulación es escalar: las filas siguen el orden de los
+        // buckets de nombre y casi nunca hay claves iguales seguidas, así que
+        // pasar tramos al núcleo de bloque resultó unas tres veces más lento
+        uint32_t key_first = (uint32_t)task->key_first;
+        for (int i = 0; i < count; i++) {
+            uint32_t key = keys[i] - key_first; // Fuera del tramo: desborda y se descarta
+            if (key >= task->group_count) continue;
+            if (values) aggregate_add(&task->cells[key], values[i]);
+            else task->cells[key].count++;
+        }
+    }
+    return NULL;
+}
+
+// Pasar los grupos no vacíos de una tabla (claves key_first..) a los
+// resultados. *result_count cuenta todos los grupos no vacíos, aunque solo se
+// guarden max_results. Sin ranked llegan por clave ascendente y se toman los
+// primeros; con ranked solo se guardan los max_results mejores, por
+// inserción ordenada (la mayoría se descarta con una comparación)
+void aggregate_collect(const AggregateSpec *spec, const AggregateCell *cells, uint64_t count,
+                       uint64_t key_first, int ranked, AggregateGroup *groups,
+                       int *result_count, int max_results) {
+    for (uint64_t g = 0; g < count; g++) {
+        if (cells[g].count == 0) continue;
+        AggregateGroup group;
+        group.key = (long)(key_first + g);
+        if (spec->group_by == AGG_BY_DECADE) group.key *= 10;
+        group.count = cells[g].count;
+        group.value = aggregate_value(spec, &cells[g]);
+        
+        int n = *result_count < max_results ? *result_count : max_results;
+        (*result_count)++;
+        if (!ranked) {
+            if (n < max_results) groups[n] = group;
+            continue;
+        }
+        
+        if (n == max_results && compare_aggregate_groups(&group, &groups[n - 1]) >= 0) continue;
+        int i = n < max_results ? n : n - 1;
+        while (i > 0 && compare_aggregate_groups(&group, &groups[i - 1]) < 0) {
+            groups[i] = groups[i - 1];
+            i--;
+        }
+        groups[i] = group;
     }
+}
+
+// Agregación sobre las columnas. Las filas se reparten en tramos alineados a
+// bloque, un hilo por núcleo, cada uno con su propia tabla de grupos que al
+// final se combinan. Los grupos son índices densos (año, década o
+// identificador de artista del diccionario), así que las tablas son arreglos.
+// Todas las tablas juntas caben en aggregate_budget: si hay más artistas de
+// los que caben, se hacen varias pasadas, cada una sobre un tramo de
+// identificadores (releer las columnas empaquetadas es barato). Si caben todos
+// los artistas se ordenan al final en lugar de insertarlos uno a uno. 0 sin memoria
+int aggregate_columns(const AggregateSpec *spec, AggregateGroup *groups, int *result_count,
+                      int max_results) {
+    uint64_t rows = column_store.header->record_count;
+    uint64_t groups_total = aggregate_group_capacity(spec->group_by);
+    if (groups_total == 0) return 1;
+    int ranked = spec->group_by == AGG_BY_ARTIST && groups_total > (uint64_t)max_results;
+    
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t blocks = (rows + AGG_BLOCK - 1) / AGG_BLOCK;
+    int threads = cpus > 0 && cpus < AGG_MAX_THREADS ? (int)cpus : AGG_MAX_THREADS;
+    if ((uint64_t)threads > blocks) threads = blocks > 0 ? (int)blocks : 1;
     
-    for (int i = 0; i < HASH_SIZE && found < max_results; i++) {
-        long current_pos = hash_table[i].first_position;
+    uint64_t span = aggregate_budget / (sizeof(AggregateCell) * threads);
+    if (span == 0) span = 1;
+    if (span > groups_total) span = groups_total;
+    AggregateCell *cells = malloc(sizeof(AggregateCell) * span * threads);
+    if (!cells) return 0;
+    
+    AggregateTask tasks[AGG_MAX_THREADS];
+    pthread_t ids[AGG_MAX_THREADS];
+    int passes = 0;
+    for (uint64_t key_first = 0; key_first < groups_total; key_first += span) {
+        uint64_t group_count = groups_total - key_first < span ? groups_total - key_first : span;
+        aggregate_cells_init(cells, group_count * threads);
+        for (int t = 0; t < threads; t++) {
+            tasks[t].spec = spec;
+            tasks[t].first = blocks * t / threads * AGG_BLOCK;
+            tasks[t].last = blocks * (t + 1) / threads * AGG_BLOCK;
+            if (tasks[t].last > rows) tasks[t].last = rows;
+            tasks[t].key_first = key_first;
+            tasks[t].group_count = group_count;
+            tasks[t].cells = cells + group_count * t;
+        }
         
-        while (current_pos != -1 && found < max_results) {
-            fseek(file, current_pos, SEEK_SET);
-            Song song;
-            if (fread(&song, sizeof(Song), 1, file) != 1) break;
-            
-            char lower_name[MAX_TITLE];
-            strncpy(lower_name, song.name, sizeof(lower_name) - 1);
-            lower_name[sizeof(lower_name) - 1] = '\0';
-            for (int j = 0; lower_name[j]; j++) {
-                lower_name[j] = tolower(lower_name[j]);
-            }
-            
-            if (strstr(lower_name, lower_word) != NULL) {
-                results[found++] = song;
+        // El hilo actual hace el primer tramo; si un hilo no arranca, su tramo se hace aquí
+        int started[AGG_MAX_THREADS] = {0};
+        for (int t = 1; t < threads; t++) {
+            started[t] = pthread_create(&ids[t], NULL, aggregate_worker, &tasks[t]) == 0;
+        }
+        aggregate_worker(&tasks[0]);
+        for (int t = 1; t < threads; t++) {
+            if (started[t]) pthread_join(ids[t], NULL);
+            else aggregate_worker(&tasks[t]);
+        }
+        
+        for (int t = 1; t < threads; t++) {
+            for (uint64_t g = 0; g < group_count; g++) {
+                aggregate_merge(&cells[g], &cells[group_count * t + g]);
             }
-            
-            current_pos = song.next;
         }
+        aggregate_collect(spec, cells, group_count, key_first, ranked, groups, result_count,
+                          max_results);
+        passes++;
+    }
+    free(cells);
+    if (spec->group_by == AGG_BY_ARTIST && !ranked) {
+        qsort(groups, *result_count, sizeof(AggregateGroup), compare_aggregate_groups);
     }
     
-    fclose(file);
-    return found;
+    int key_bytes = spec->group_by == AGG_BY_ARTIST ? sizeof(uint32_t) :
+                    spec->group_by == AGG_BY_TOTAL ? 0 : sizeof(int16_t);
+    int value_bytes = spec->function == AGG_COUNT ? 0 :
+                      spec->field == ORDER_YEAR ? sizeof(int16_t) : sizeof(float);
+    g_query.records_scanned += rows * passes;
+    g_query.bytes_read += rows * passes * (key_bytes + value_bytes);
+    return 1;
 }
 
-// Función para buscar por artista
-int search_by_artist(const char *filename, const char *artist, Song *results, int max_results) {
-    FILE *file = fopen(filename, "rb");
-    if (!file) return 0;
+// Cada grupo se devuelve como una canción: name = etiqueta, year = clave,
+// duration_ms = canciones del grupo y energy = valor agregado
+void aggregate_group_song(const AggregateSpec *spec, const AggregateGroup *group, Song *song) {
+    memset(song, 0, sizeof(Song));
+    if (spec->group_by == AGG_BY_ARTIST) {
+        if (!column_string(&column_store, &column_store.artists[group->key],
+                           song->name, sizeof(song->name))) {
+            strcpy(song->name, "?");
+        }
+    } else if (spec->group_by == AGG_BY_TOTAL) {
+        strcpy(song->name, "Total");
+    } else {
+        snprintf(song->name, sizeof(song->name),
+                 spec->group_by == AGG_BY_DECADE ? "%lds" : "%ld", group->key);
+        song->year = (int)group->key;
+    }
+    song->duration_ms = (int)group->count;
+    song->energy = group->value;
+}
+
+// Consulta de agregación "funcion:campo:grupo". Devuelve el total de grupos
+// no vacíos; solo los primeros max_results pasan a results. Año, década y
+// total salen por clave ascendente; los artistas, por valor descendente
+int aggregate_query(const char *text, Song *results, int max_results) {
+    AggregateSpec spec;
+    if (!aggregate_parse(text, &spec) || max_results <= 0) return 0;
     
-    HashEntry hash_table[HASH_SIZE];
-    if (fread(hash_table, sizeof(HashEntry), HASH_SIZE, file) != HASH_SIZE) {
-        fclose(file);
+    AggregateGroup *groups = malloc(sizeof(AggregateGroup) * max_results);
+    if (!groups) return 0;
+    
+    uint64_t trace_start = trace_now();
+    int result_count = 0;
+    int ok = aggregate_columns(&spec, groups, &result_count, max_results);
+    trace_span("scan", trace_start);
+    if (!ok) {
+        free(groups);
         return 0;
     }
     
-    int found = 0;
-    char lower_artist[MAX_ARTIST];
-    strncpy(lower_artist, artist, sizeof(lower_artist) - 1);
-    lower_artist[sizeof(lower_artist) - 1] = '\0';
-    for (int i = 0; lower_artist[i]; i++) {
-        lower_artist[i] = tolower(lower_artist[i]);
+    trace_start = trace_now();
+    for (int i = 0; i < result_count && i < max_results; i++) {
+        aggregate_group_song(&spec, &groups[i], &results[i]);
     }
+    trace_span("merge", trace_start);
+    
+    free(groups);
+    return result_count;
+}
+
+// Ejecutar una consulta completa: predicado, orden y límite
+int execute_query(const char *bin_filename, const Query *query, Song *results) {
+    int limit = query->limit > 0 && query->limit < MAX_RESULTS ? query->limit : MAX_RESULTS;
+    TopK topk;
+    TopK *ordered = NULL;
     
-    for (int i = 0; i < HASH_SIZE && found < max_results; i++) {
-        long current_pos = hash_table[i].first_position;
+    // Estadísticas, similares, autocompletado y agregación tienen su propio orden
+    if (query->order_field > ORDER_NONE && query->order_field <= ORDER_FIELDS &&
+        query->search_type != 5 && query->search_type < 7) {
+        int found = search_ordered_by_index(bin_filename, query, results, limit);
+        if (found >= 0) {
+            songs_load_texts(results, found);
+            return found;
+        }
         
-        while (current_pos != -1 && found < max_results) {
-            fseek(file, current_pos, SEEK_SET);
-            Song song;
-            if (fread(&song, sizeof(Song), 1, file) != 1) break;
-            
-            char lower_song_artists[MAX_ARTIST];
-            strncpy(lower_song_artists, song.artists, sizeof(lower_song_artists) - 1);
-            lower_song_artists[sizeof(lower_song_artists) - 1] = '\0';
-            for (int j = 0; lower_song_artists[j]; j++) {
-                lower_song_artists[j] = tolower(lower_song_artists[j]);
-            }
-            
-            if (strstr(lower_song_artists, lower_artist) != NULL) {
-                results[found++] = song;
+        topk_init(&topk, query->order_field, query->order_desc, limit);
+        ordered = &topk;
+    }
+    
+    int result_count = 0;
+    switch (query->search_type) {
+        case 1: // Nombre exacto
+            result_count = search_by_exact_name(bin_filename, query->search_term,
+                                               results, limit, ordered);
+            break;
+        case 2: // Palabra en nombre
+            result_count = search_by_name_word(bin_filename, query->search_term,
+                                              results, limit, ordered);
+            break;
+        case 3: // Artista
+            result_count = search_by_artist(bin_filename, query->search_term,
+                                           results, limit, ordered);
+            break;
+        case 4: // Año
+            result_count = search_by_year(bin_filename, query->search_year,
+                                         results, limit, ordered);
+            break;
+        case 5: // Estadísticas
+            {
+                int total_songs, min_year, max_year;
+                if (get_database_stats(bin_filename, &total_songs, &min_year, &max_year) == 0) {
+                    result_count = total_songs;
+                    results[0].year = min_year;
+                    results[0].duration_ms = max_year;
+                }
             }
-            
-            current_pos = song.next;
-        }
+            break;
+        case 6: // Nombre aproximado
+            result_count = search_by_fuzzy_name(bin_filename, query->search_term,
+                                               results, limit, ordered);
+            break;
+        case 7: // Canciones similares
+            result_count = search_similar_songs(bin_filename, query->search_term, results, limit);
+            break;
+        case 8: // Autocompletado
+            result_count = search_completions(query->search_term, results, limit);
+            break;
+        case AGGREGATE_SEARCH_TYPE: // Agregación por grupos
+            result_count = aggregate_query(query->search_term, results, limit);
+            break;
     }
     
-    fclose(file);
-    return found;
+    if (ordered) {
+        result_count = topk_drain(ordered, results);
+    }
+    
+    // Solo las canciones que se devuelven leen su texto del diccionario
+    if (query->search_type != 5 && query->search_type < 8) {
+        songs_load_texts(results, result_count);
+    }
+    return result_count;
 }
 
-// Función para buscar por año
-int search_by_year(const char *filename, int year, Song *results, int max_results) {
-    FILE *file = fopen(filename, "rb");
-    if (!file) return 0;
-    
-    HashEntry hash_table[HASH_SIZE];
-    if (fread(hash_table, sizeof(HashEntry), HASH_SIZE, file) != HASH_SIZE) {
-        fclose(file);
-        return 0;
+// Escribir una coincidencia etiquetada con el número de consulta (1..N)
+void batch_write(FILE *out, int query_number, const Query *query, const Song *song) {
+    if (query->search_type == 8) {
+        // Autocompletado: término, tipo, canciones, año más reciente
+        fprintf(out, "%d\t%s\t%s\t%d\t%d\n", query_number, song->name, song->id,
+                song->duration_ms, song->year);
+    } else if (query->search_type == AGGREGATE_SEARCH_TYPE) {
+        // Agregación: grupo, canciones del grupo, valor
+        fprintf(out, "%d\t%s\t%d\t%.6f\n", query_number, song->name, song->duration_ms, song->energy);
+    } else {
+        fprintf(out, "%d\t%s\t%s\t%s\t%s\t%d\t%d\n", query_number, song->id, song->name,
+                song->artists, song->album, song->year, song->duration_ms);
     }
+}
+
+// Agregación del lote: no pasa por el arreglo de MAX_RESULTS, así que -n 0
+// devuelve todos los grupos (a lo sumo AGG_MAX_YEAR años o uno por artista).
+// Si el límite deja grupos fuera se avisa con una línea "#". Devuelve las
+// líneas escritas y deja en *group_total el total de grupos no vacíos
+int batch_aggregate(FILE *out, int query_number, const Query *query, int *group_total) {
+    AggregateSpec spec;
+    *group_total = 0;
+    if (!aggregate_parse(query->search_term, &spec)) return 0;
     
-    int found = 0;
+    uint64_t capacity = aggregate_group_capacity(spec.group_by);
+    if (query->limit > 0 && (uint64_t)query->limit < capacity) capacity = query->limit;
+    AggregateGroup *groups = malloc(sizeof(AggregateGroup) * (capacity > 0 ? capacity : 1));
+    if (!groups) return 0;
     
-    for (int i = 0; i < HASH_SIZE && found < max_results; i++) {
-        long current_pos = hash_table[i].first_position;
-        
-        while (current_pos != -1 && found < max_results) {
-            fseek(file, current_pos, SEEK_SET);
-            Song song;
-            if (fread(&song, sizeof(Song), 1, file) != 1) break;
-            
-            if (song.year == year) {
-                results[found++] = song;
-            }
-            
-            current_pos = song.next;
+    uint64_t trace_start = trace_now();
+    int ok = aggregate_columns(&spec, groups, group_total, (int)capacity);
+    trace_span("scan", trace_start);
+    int written = 0;
+    if (ok) {
+        Song song;
+        written = *group_total < (int)capacity ? *group_total : (int)capacity;
+        for (int i = 0; i < written; i++) {
+            aggregate_group_song(&spec, &groups[i], &song);
+            batch_write(out, query_number, query, &song);
+        }
+        if (written < *group_total) {
+            fprintf(out, "# %d. se devuelven %d de %d grupos\n", query_number, written, *group_total);
         }
     }
-    
-    fclose(file);
-    return found;
+    free(groups);
+    return written;
 }
 
-// Función para mostrar estadísticas
-int get_database_stats(const char *filename, int *total_songs, int *min_year, int *max_year) {
-    FILE *file = fopen(filename, "rb");
-    if (!file) return -1;
+// Ejecutar un lote: las consultas de nombre, palabra, artista y año se
+// resuelven juntas en un solo recorrido que evalúa todos los predicados
+// pendientes sobre cada registro; las demás se ejecutan una por una
+int execute_batch(const char *bin_filename) {
+    BatchData *batch = (BatchData*)shmat(shared_data->batch_shm_id, NULL, 0);
+    if (batch == (void*)-1) return 0;
     
-    HashEntry hash_table[HASH_SIZE];
-    if (fread(hash_table, sizeof(HashEntry), HASH_SIZE, file) != HASH_SIZE) {
-        fclose(file);
-        return -1;
+    FILE *out = stdout;
+    if (batch->output_path[0] != '\0') {
+        out = fopen(batch->output_path, "w");
+        if (!out) {
+            printf("Error creando archivo de salida %s\n", batch->output_path);
+            shmdt(batch);
+            return 0;
+        }
     }
     
-    *total_songs = 0;
-    *min_year = 3000;
-    *max_year = 0;
+    int count = batch->count < BATCH_MAX ? batch->count : BATCH_MAX;
+    int total = 0;
     
-    for (int i = 0; i < HASH_SIZE; i++) {
-        long current_pos = hash_table[i].first_position;
-        
-        while (current_pos != -1) {
-            (*total_songs)++;
-            fseek(file, current_pos, SEEK_SET);
-            Song song;
-            if (fread(&song, sizeof(Song), 1, file) != 1) break;
-            
-            if (song.year < *min_year) *min_year = song.year;
-            if (song.year > *max_year) *max_year = song.year;
+    // Consultas que se resuelven en el recorrido compartido
+    static char lower_terms[BATCH_MAX][MAX_TITLE];
+    static int pending[BATCH_MAX];
+    static const char *artist_patterns[BATCH_MAX];
+    static uint64_t *artist_sets[BATCH_MAX];
+    static int artist_set_of[BATCH_MAX];
+    int pending_count = 0;
+    int artist_count = 0;
+    for (int q = 0; q < count; q++) {
+        batch->result_counts[q] = 0;
+        if (batch->queries[q].search_type >= 1 && batch->queries[q].search_type <= 4) {
+            to_lower_copy(lower_terms[q], batch->queries[q].search_term, sizeof(lower_terms[q]));
+            pending[pending_count++] = q;
+            if (batch->queries[q].search_type == 3) {
+                artist_set_of[q] = artist_count;
+                artist_patterns[artist_count++] = lower_terms[q];
+            }
+        }
+    }
+    
+    // Los artistas se deciden por identificador: un conjunto por consulta
+    int sets_ready = artist_count == 0 || artist_match_sets(artist_patterns, artist_count, artist_sets);
+    FILE *file = pending_count > 0 && sets_ready ? fopen(bin_filename, "rb") : NULL;
+    SongCursor cursor;
+    if (file && cursor_open(&cursor, file)) {
+        uint64_t trace_start = trace_now();
+        Song *song;
+        while (pending_count > 0 && (song = cursor_next(&cursor)) != NULL) {
+            // El nombre se pasa a minúsculas una vez por registro
+            char lower_name[MAX_TITLE];
+            to_lower_copy(lower_name, song->name, sizeof(lower_name));
+            int texts_loaded = 0;
             
-            current_pos = song.next;
+            for (int p = 0; p < pending_count; p++) {
+                int q = pending[p];
+                const Query *query = &batch->queries[q];
+                int match;
+                switch (query->search_type) {
+                    case 1:  match = strcmp(lower_name, lower_terms[q]) == 0; break;
+                    case 2:  match = strstr(lower_name, lower_terms[q]) != NULL; break;
+                    case 3:  match = artist_in_set(artist_sets[artist_set_of[q]], song->artist_id); break;
+                    default: match = song->year == query->search_year; break;
+                }
+                if (!match) continue;
+                
+                if (!texts_loaded) {
+                    songs_load_texts(song, 1);
+                    texts_loaded = 1;
+                }
+                batch_write(out, q + 1, query, song);
+                total++;
+                if (++batch->result_counts[q] == query->limit) {
+                    pending[p--] = pending[--pending_count]; // Consulta completa
+                }
+            }
         }
+        trace_span("scan", trace_start);
+    }
+    if (file) fclose(file);
+    for (int a = 0; sets_ready && a < artist_count; a++) {
+        free(artist_sets[a]);
     }
     
-    fclose(file);
-    return 0;
+    // Resto de tipos: una ejecución por consulta. Sus resultados pasan por el
+    // arreglo de MAX_RESULTS, así que -n 0 o mayor que MAX_RESULTS quedan en
+    // MAX_RESULTS (solo el recorrido compartido y la agregación admiten "sin límite")
+    static Song results[MAX_RESULTS];
+    for (int q = 0; q < count; q++) {
+        const Query *query = &batch->queries[q];
+        if (query->search_type >= 1 && query->search_type <= 4) continue;
+        if (query->search_type == AGGREGATE_SEARCH_TYPE) {
+            total += batch_aggregate(out, q + 1, query, &batch->result_counts[q]);
+            continue;
+        }
+        
+        int found = execute_query(bin_filename, query, results);
+        if (query->search_type == 5) {
+            fprintf(out, "%d\t%d\t%d\t%d\n", q + 1, found, results[0].year, results[0].duration_ms);
+        } else {
+            for (int i = 0; i < found; i++) {
+                batch_write(out, q + 1, query, &results[i]);
+            }
+        }
+        batch->result_counts[q] = found;
+        total += query->search_type == 5 ? 1 : found;
+    }
+    
+    fflush(out);
+    if (out != stdout) fclose(out);
+    shmdt(batch);
+    return total;
+}
+
+// Interpretar "tipo:valor" (nombre, palabra, artista, año, estadisticas,
+// aproximada, similares, autocompletar, agregar); 0 si no es válida
+int parse_batch_query(const char *spec, Query *query, int limit) {
+    static const struct { const char *name; int type; } types[] = {
+        {"nombre", 1}, {"palabra", 2}, {"artista", 3}, {"año", 4}, {"anio", 4},
+        {"estadisticas", 5}, {"estadísticas", 5}, {"aproximada", 6},
+        {"similares", 7}, {"autocompletar", 8}, {"agregar", AGGREGATE_SEARCH_TYPE}
+    };
+    
+    const char *colon = strchr(spec, ':');
+    size_t name_length = colon ? (size_t)(colon - spec) : strlen(spec);
+    memset(query, 0, sizeof(Query));
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        if (strlen(types[t].name) == name_length && strncasecmp(spec, types[t].name, name_length) == 0) {
+            query->search_type = types[t].type;
+            break;
+        }
+    }
+    if (query->search_type == 0) return 0;
+    
+    const char *value = colon ? colon + 1 : "";
+    strncpy(query->search_term, value, sizeof(query->search_term) - 1);
+    query->search_year = atoi(value);
+    query->order_field = ORDER_NONE;
+    query->limit = limit;
+    if (query->search_type != 5 && query->search_term[0] == '\0') return 0;
+    if (query->search_type == 4 && query->search_year <= 0) return 0;
+    if (query->search_type == AGGREGATE_SEARCH_TYPE) {
+        AggregateSpec spec;
+        return aggregate_parse(query->search_term, &spec);
+    }
+    return 1;
 }
 
 // Función para enviar solicitud y esperar respuesta
 int send_search_request(int search_type, const char *search_term, int search_year) {
+    static uint32_t next_request_id = 0;
+    trace_request_id = ++next_request_id;
+    uint64_t trace_start = trace_now();
+    
     // Preparar solicitud
     sem_wait(sem_id);
     
+    shared_data->request_id = trace_request_id;
+    shared_data->enqueue_ns = trace_start;
     shared_data->search_type = search_type;
     shared_data->search_year = search_year;
+    shared_data->order_field = ui_order_field;
+    shared_data->order_desc = ui_order_desc;
+    shared_data->limit = ui_limit;
     if (search_term) {
         strncpy(shared_data->search_term, search_term, sizeof(shared_data->search_term) - 1);
         shared_data->search_term[sizeof(shared_data->search_term) - 1] = '\0';
@@ -379,23 +3418,110 @@ int send_search_request(int search_type, const char *search_term, int search_yea
     }
     shared_data->response_ready = 0; // Respuesta no lista
     shared_data->request_ready = 1;  // Solicitud lista
+    metrics_queue_add(1);
     
     sem_signal(sem_id);
+    trace_span("enqueue", trace_start);
     
     // Esperar respuesta (polling eficiente)
     clock_t start = clock();
     
     while (shared_data->response_ready == 0) {
+        if (shared_data->shutdown) { // El proceso de base de datos no pudo abrirla
+            printf("Error: el proceso de base de datos terminó\n");
+            return -1;
+        }
         if ((clock() - start) / CLOCKS_PER_SEC > 10) { // Timeout de 10 segundos
             printf("Error: Timeout en la búsqueda\n");
             return -1;
         }
         usleep(1000); // Solo 1ms de espera entre verificaciones
     }
+    trace_span("wait_response", trace_start);
     
     return 0;
 }
 
+// Modo por lotes: enviar todas las consultas (-q y archivo -b) de una vez
+// y mostrar cuántos resultados obtuvo cada una
+int batch_client_process(char **specs, int spec_count, const char *batch_file, int limit,
+                         const char *output_path) {
+    // Segmento privado: el proceso de búsqueda lo recibe por el canal compartido
+    batch_shm_id = shmget(IPC_PRIVATE, sizeof(BatchData), IPC_CREAT | 0600);
+    if (batch_shm_id == -1) {
+        perror("Error creando memoria compartida del lote");
+        return 1;
+    }
+    BatchData *batch = (BatchData*)shmat(batch_shm_id, NULL, 0);
+    if (batch == (void*)-1) {
+        perror("Error adjuntando memoria compartida del lote");
+        return 1;
+    }
+    memset(batch, 0, sizeof(BatchData));
+    shared_data->batch_shm_id = batch_shm_id;
+    if (output_path) {
+        strncpy(batch->output_path, output_path, sizeof(batch->output_path) - 1);
+    }
+    
+    int errors = 0;
+    for (int i = 0; i < spec_count && batch->count < BATCH_MAX; i++) {
+        if (parse_batch_query(specs[i], &batch->queries[batch->count], limit)) {
+            batch->count++;
+        } else {
+            printf("Consulta inválida: %s\n", specs[i]);
+            errors++;
+        }
+    }
+    
+    if (batch_file) {
+        FILE *file = fopen(batch_file, "r");
+        if (!file) {
+            printf("Error abriendo archivo de consultas: %s\n", batch_file);
+            errors++;
+        } else {
+            char line[512];
+            while (fgets(line, sizeof(line), file)) {
+                line[strcspn(line, "\r\n")] = '\0';
+                if (line[0] == '\0' || line[0] == '#') continue;
+                if (batch->count == BATCH_MAX) {
+                    printf("Aviso: se ignoran las consultas después de la %d\n", BATCH_MAX);
+                    break;
+                }
+                if (parse_batch_query(line, &batch->queries[batch->count], limit)) {
+                    batch->count++;
+                } else {
+                    printf("Consulta inválida: %s\n", line);
+                    errors++;
+                }
+            }
+            fclose(file);
+        }
+    }
+    
+    if (batch->count > 0) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (send_search_request(BATCH_SEARCH_TYPE, NULL, 0) == 0) {
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            printf("# Lote: %d consultas, %d resultados en %.3f segundos\n", batch->count,
+                   shared_data->result_count,
+                   (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+            for (int q = 0; q < batch->count; q++) {
+                printf("# %d. %s: %d resultados\n", q + 1,
+                       batch->queries[q].search_type == 5 ? "estadísticas" : batch->queries[q].search_term,
+                       batch->result_counts[q]);
+            }
+        } else {
+            errors++;
+        }
+    }
+    
+    shmdt(batch);
+    shmctl(batch_shm_id, IPC_RMID, NULL);
+    batch_shm_id = -1;
+    return errors > 0;
+}
+
 // Proceso de interfaz de usuario
 void user_interface_process() {
     printf("=== SISTEMA DE BÚSQUEDA DE CANCIONES ===\n");
@@ -413,6 +3539,13 @@ void user_interface_process() {
         printf("4. Buscar por año\n");
         printf("5. Mostrar estadísticas\n");
         printf("6. Salir\n");
+        printf("7. Configurar orden de resultados (actual: %s%s, máximo %d)\n",
+               order_field_name(ui_order_field),
+               ui_order_field == ORDER_NONE ? "" : (ui_order_desc ? " desc" : " asc"), ui_limit);
+        printf("8. Buscar por nombre aproximado (hasta %d errores)\n", FUZZY_MAX_EDITS);
+        printf("9. Buscar canciones similares a un ID\n");
+        printf("10. Autocompletar nombre o artista\n");
+        printf("11. Agregar por año, década o artista (COUNT/SUM/AVG/MIN/MAX)\n");
         printf("Seleccione una opción: ");
         
         if (safe_scanf_int("%d", &option) != 1) {
@@ -429,7 +3562,108 @@ void user_interface_process() {
                 safe_fgets(search_term, sizeof(search_term));
                 if (strlen(search_term) > 0) {
                     start = clock();
-                    if (send_search_request(1, search_term, 0) == 0) {
+                    if (send_search_request(1, search_term, 0) == 0) {
+                        end = clock();
+                        cpu_time_used = ((double)(end - start)) / CLOCKS_PER_SEC;
+                        display_results();
+                        printf("\nTiempo de búsqueda: %.3f segundos\n", cpu_time_used);
+                    }
+                }
+                break;
+                
+            case 2:
+                printf("Ingrese palabra a buscar en nombres: ");
+                safe_fgets(search_term, sizeof(search_term));
+                if (strlen(search_term) > 0) {
+                    start = clock();
+                    if (send_search_request(2, search_term, 0) == 0) {
+                        end = clock();
+                        cpu_time_used = ((double)(end - start)) / CLOCKS_PER_SEC;
+                        display_results();
+                        printf("\nTiempo de búsqueda: %.3f segundos\n", cpu_time_used);
+                    }
+                }
+                break;
+                
+            case 3:
+                printf("Ingrese nombre del artista: ");
+                safe_fgets(search_term, sizeof(search_term));
+                if (strlen(search_term) > 0) {
+                    start = clock();
+                    if (send_search_request(3, search_term, 0) == 0) {
+                        end = clock();
+                        cpu_time_used = ((double)(end - start)) / CLOCKS_PER_SEC;
+                        display_results();
+                        printf("\nTiempo de búsqueda: %.3f segundos\n", cpu_time_used);
+                    }
+                }
+                break;
+                
+            case 4:
+                printf("Ingrese año a buscar: ");
+                if (safe_scanf_int("%d", &search_year) == 1) {
+                    start = clock();
+                    if (send_search_request(4, NULL, search_year) == 0) {
+                        end = clock();
+                        cpu_time_used = ((double)(end - start)) / CLOCKS_PER_SEC;
+                        display_results();
+                        printf("\nTiempo de búsqueda: %.3f segundos\n", cpu_time_used);
+                    }
+                } else {
+                    printf("Año inválido\n");
+                }
+                break;
+                
+            case 5:
+                start = clock();
+                if (send_search_request(5, NULL, 0) == 0) {
+                    end = clock();
+                    cpu_time_used = ((double)(end - start)) / CLOCKS_PER_SEC;
+                    printf("\n=== ESTADÍSTICAS DE LA BASE DE DATOS ===\n");
+                    printf("Total de canciones: %d\n", shared_data->result_count);
+                    printf("Rango de años: %d - %d\n", 
+                           shared_data->results[0].year, shared_data->results[0].duration_ms);
+                    printf("Tamaño de la tabla hash: %d\n", HASH_SIZE);
+                    printf("Tiempo de búsqueda: %.3f segundos\n", cpu_time_used);
+                }
+                break;
+                
+            case 6:
+                printf("Saliendo...\n");
+                break;
+                
+            case 7:
+                {
+                    int field, desc, limit;
+                    printf("Ordenar por (0=ninguno, 1=energía, 2=bailabilidad, 3=tempo, 4=duración, 5=año): ");
+                    if (safe_scanf_int("%d", &field) != 1 || field < ORDER_NONE || field > ORDER_FIELDS) {
+                        printf("Campo inválido\n");
+                        break;
+                    }
+                    ui_order_field = field;
+                    
+                    if (field != ORDER_NONE) {
+                        printf("Dirección (1=descendente, 0=ascendente): ");
+                        if (safe_scanf_int("%d", &desc) == 1) {
+                            ui_order_desc = desc != 0;
+                        }
+                    }
+                    
+                    printf("Máximo de resultados (1-%d): ", MAX_RESULTS);
+                    if (safe_scanf_int("%d", &limit) == 1 && limit >= 1 && limit <= MAX_RESULTS) {
+                        ui_limit = limit;
+                    } else {
+                        printf("Límite inválido, se mantiene %d\n", ui_limit);
+                    }
+                }
+                break;
+                
+            case 8:
+                printf("Ingrese el nombre aproximado de la canción: ");
+                safe_fgets(search_term, sizeof(search_term));
+                if (strlen(search_term) > 0) {
+                    start = clock();
+                    if (send_search_request(6, search_term, 0) == 0) {
                         end = clock();
                         cpu_time_used = ((double)(end - start)) / CLOCKS_PER_SEC;
                         display_results();
@@ -438,12 +3672,12 @@ void user_interface_process() {
                 }
                 break;
                 
-            case 2:
-                printf("Ingrese palabra a buscar en nombres: ");
+            case 9:
+                printf("Ingrese el ID de la canción: ");
                 safe_fgets(search_term, sizeof(search_term));
                 if (strlen(search_term) > 0) {
                     start = clock();
-                    if (send_search_request(2, search_term, 0) == 0) {
+                    if (send_search_request(7, search_term, 0) == 0) {
                         end = clock();
                         cpu_time_used = ((double)(end - start)) / CLOCKS_PER_SEC;
                         display_results();
@@ -452,12 +3686,12 @@ void user_interface_process() {
                 }
                 break;
                 
-            case 3:
-                printf("Ingrese nombre del artista: ");
+            case 10:
+                printf("Ingrese el comienzo del nombre o artista: ");
                 safe_fgets(search_term, sizeof(search_term));
                 if (strlen(search_term) > 0) {
                     start = clock();
-                    if (send_search_request(3, search_term, 0) == 0) {
+                    if (send_search_request(8, search_term, 0) == 0) {
                         end = clock();
                         cpu_time_used = ((double)(end - start)) / CLOCKS_PER_SEC;
                         display_results();
@@ -466,39 +3700,43 @@ void user_interface_process() {
                 }
                 break;
                 
-            case 4:
-                printf("Ingrese año a buscar: ");
-                if (safe_scanf_int("%d", &search_year) == 1) {
+            case 11:
+                {
+                    static const char *functions[] = {"count", "sum", "avg", "min", "max"};
+                    static const char *fields[] = {"energia", "bailabilidad", "tempo", "duracion", "anio"};
+                    static const char *groups[] = {"anio", "decada", "artista", "total"};
+                    int function, field = 1, group;
+                    
+                    printf("Función (1=COUNT, 2=SUM, 3=AVG, 4=MIN, 5=MAX): ");
+                    if (safe_scanf_int("%d", &function) != 1 || function < AGG_COUNT || function > AGG_MAX) {
+                        printf("Función inválida\n");
+                        break;
+                    }
+                    if (function != AGG_COUNT) {
+                        printf("Campo (1=energía, 2=bailabilidad, 3=tempo, 4=duración, 5=año): ");
+                        if (safe_scanf_int("%d", &field) != 1 || field < ORDER_ENERGY || field > ORDER_FIELDS) {
+                            printf("Campo inválido\n");
+                            break;
+                        }
+                    }
+                    printf("Agrupar por (1=año, 2=década, 3=artista, 4=total): ");
+                    if (safe_scanf_int("%d", &group) != 1 || group < AGG_BY_YEAR || group > AGG_BY_TOTAL) {
+                        printf("Grupo inválido\n");
+                        break;
+                    }
+                    
+                    snprintf(search_term, sizeof(search_term), "%s:%s:%s", functions[function - 1],
+                             function == AGG_COUNT ? "" : fields[field - 1], groups[group - 1]);
                     start = clock();
-                    if (send_search_request(4, NULL, search_year) == 0) {
+                    if (send_search_request(AGGREGATE_SEARCH_TYPE, search_term, 0) == 0) {
                         end = clock();
                         cpu_time_used = ((double)(end - start)) / CLOCKS_PER_SEC;
                         display_results();
                         printf("\nTiempo de búsqueda: %.3f segundos\n", cpu_time_used);
                     }
-                } else {
-                    printf("Año inválido\n");
-                }
-                break;
-                
-            case 5:
-                start = clock();
-                if (send_search_request(5, NULL, 0) == 0) {
-                    end = clock();
-                    cpu_time_used = ((double)(end - start)) / CLOCKS_PER_SEC;
-                    printf("\n=== ESTADÍSTICAS DE LA BASE DE DATOS ===\n");
-                    printf("Total de canciones: %d\n", shared_data->result_count);
-                    printf("Rango de años: %d - %d\n", 
-                           shared_data->results[0].year, shared_data->results[0].duration_ms);
-                    printf("Tamaño de la tabla hash: %d\n", HASH_SIZE);
-                    printf("Tiempo de búsqueda: %.3f segundos\n", cpu_time_used);
                 }
                 break;
                 
-            case 6:
-                printf("Saliendo...\n");
-                break;
-                
             default:
                 printf("Opción no válida\n");
         }
@@ -506,25 +3744,117 @@ void user_interface_process() {
     } while (option != 6);
 }
 
+// Abrir la base: índices auxiliares y buffer pool. Devuelve el número de
+// registros o -1 si la base o su diccionario de textos no existen
+long database_open(const char *bin_filename) {
+    // Verificar si existe la base de datos
+    FILE *test_file = fopen(bin_filename, "rb");
+    if (!test_file) {
+        printf("ERROR: No se encuentra la base de datos '%s'\n", bin_filename);
+        printf("Ejecute primero el programa creador de la base de datos.\n");
+        return -1;
+    }
+    long record_count = count_records(test_file);
+    fclose(test_file);
+    
+    // Las tablas de agregación salen de -m antes que los índices opcionales
+    if (memory_budget > 0 && aggregate_budget > memory_budget / 8) {
+        aggregate_budget = memory_budget / 8;
+    }
+    memory_reserved = memory_budget > 0 ? aggregate_budget : 0;
+    
+    // Los registros guardan el álbum y los artistas como identificadores:
+    // sin el diccionario no se puede responder ninguna consulta
+    if (!column_store_load(&column_store, COL_FILENAME, record_count)) {
+        printf("ERROR: falta el diccionario de textos '%s' o no corresponde a la base\n",
+               COL_FILENAME);
+        printf("Ejecute primero el programa creador de la base de datos.\n");
+        return -1;
+    }
+    printf("Diccionario de artistas y álbumes: %s (%llu artistas, %llu álbumes%s)\n",
+           COL_FILENAME, (unsigned long long)column_store.header->artist_count,
+           (unsigned long long)column_store.header->album_count,
+           column_store.header->flags & COL_COMPRESSED ? ", LZ4" : "");
+    
+    if (mph_load(&name_mph, MPH_FILENAME, record_count)) {
+        printf("Índice de nombres exactos: %s (%llu nombres)\n", MPH_FILENAME,
+               (unsigned long long)name_mph.header.key_count);
+    }
+    if (bucket_dir_load(&bucket_dir, DIR_FILENAME, record_count)) {
+        printf("Base agrupada por bucket: recorridos secuenciales (%s)\n", DIR_FILENAME);
+    }
+    if (sort_index_load(&sort_index, SORT_FILENAME, record_count)) {
+        printf("Índice ordenado por campo numérico: %s\n", SORT_FILENAME);
+    }
+    if (fuzzy_load(&fuzzy_index, FUZZY_FILENAME, record_count)) {
+        printf("Índice aproximado de nombres: %s (%llu nombres)\n", FUZZY_FILENAME,
+               (unsigned long long)fuzzy_index.header->name_count);
+    }
+    if (complete_load(&complete_index, COMPLETE_FILENAME, record_count)) {
+        printf("Índice de autocompletado: %s\n", COMPLETE_FILENAME);
+    }
+    if (vector_load(&vector_index, VEC_FILENAME, record_count)) {
+        printf("Índice de vectores para similares: %s\n", VEC_FILENAME);
+    }
+    if (bloom_load(&name_bloom, BLOOM_FILENAME, record_count)) {
+        printf("Filtro de Bloom de nombres: %s\n", BLOOM_FILENAME);
+    }
+    
+    // El pool se queda con lo que dejan los índices y la agregación
+    if (memory_budget > 0 && pool_open(&buffer_pool, bin_filename, memory_budget - memory_reserved,
+                                       pool_direct)) {
+        printf("Buffer pool: %d páginas de %d bytes (%ld KB)%s\n", buffer_pool.frame_count,
+               POOL_PAGE_SIZE, (long)buffer_pool.frame_count * POOL_PAGE_SIZE / 1024,
+               buffer_pool.direct ? ", O_DIRECT" : "");
+    }
+    
+    // Los archivos mapeados son caché de páginas del kernel (compartida y
+    // recuperable), no memoria propia: se informan pero no cuentan en -m
+    size_t mapped = column_store.map_size + fuzzy_index.map_size + vector_index.map_size +
+                    complete_index.map_size;
+    if (memory_budget > 0) {
+        printf("Memoria (-m %ld KB): pool %ld KB, índices y agregación %ld KB; "
+               "archivos mapeados %zu KB fuera del presupuesto\n", memory_budget / 1024,
+               (memory_budget - memory_reserved) / 1024, memory_reserved / 1024, mapped / 1024);
+    }
+    
+    if (metrics) {
+        metrics->server_pid = getpid();
+        metrics->pool_budget = buffer_pool.fd != -1 ?
+                               (uint64_t)buffer_pool.frame_count * POOL_PAGE_SIZE : 0;
+    }
+    
+    printf("Base de datos cargada: %s\n", bin_filename);
+    return record_count;
+}
+
+// Liberar lo cargado por database_open
+void database_close() {
+    mph_free(&name_mph);
+    if (sort_index.file) fclose(sort_index.file);
+    if (fuzzy_index.map) munmap(fuzzy_index.map, fuzzy_index.map_size);
+    if (vector_index.map) munmap(vector_index.map, vector_index.map_size);
+    if (complete_index.map) munmap(complete_index.map, complete_index.map_size);
+    if (column_store.map) munmap(column_store.map, column_store.map_size);
+    free(name_bloom.blocks);
+    free(fuzzy_candidates);
+    free(fuzzy_matches);
+    pool_close(&buffer_pool);
+}
+
 // Proceso de base de datos
 void database_process() {
     printf("Proceso de Base de Datos iniciado (PID: %d)\n", getpid());
     
     const char *bin_filename = "songs_database.bin";
     
-    // Verificar si existe la base de datos
-    FILE *test_file = fopen(bin_filename, "rb");
-    if (!test_file) {
-        printf("ERROR: No se encuentra la base de datos '%s'\n", bin_filename);
-        printf("Ejecute primero el programa creador de la base de datos.\n");
+    if (database_open(bin_filename) < 0) {
         sem_wait(sem_id);
         shared_data->shutdown = 1;
         sem_signal(sem_id);
         exit(1);
     }
-    fclose(test_file);
     
-    printf("Base de datos cargada: %s\n", bin_filename);
     printf("Esperando solicitudes de búsqueda...\n");
     
     // Bucle principal del proceso de base de datos
@@ -539,64 +3869,668 @@ void database_process() {
         
         if (shared_data->request_ready) {
             // Procesar solicitud
-            int search_type = shared_data->search_type;
-            char search_term[256];
-            int search_year = shared_data->search_year;
-            strcpy(search_term, shared_data->search_term);
+            Query query;
+            query.search_type = shared_data->search_type;
+            query.search_year = shared_data->search_year;
+            strcpy(query.search_term, shared_data->search_term);
+            query.order_field = shared_data->order_field;
+            query.order_desc = shared_data->order_desc;
+            query.limit = shared_data->limit;
+            trace_request_id = shared_data->request_id;
+            if (shared_data->enqueue_ns != 0) {
+                trace_span("wakeup", shared_data->enqueue_ns);
+            }
             
             shared_data->request_ready = 0; // Solicitud en procesamiento
+            metrics_queue_add(-1);
             sem_signal(sem_id);
             
             // Realizar búsqueda (fuera del semáforo para no bloquear)
-            int result_count = 0;
-            switch (search_type) {
-                case 1: // Nombre exacto
-                    result_count = search_by_exact_name(bin_filename, search_term, 
-                                                       shared_data->results, MAX_RESULTS);
-                    break;
-                case 2: // Palabra en nombre
-                    result_count = search_by_name_word(bin_filename, search_term, 
-                                                      shared_data->results, MAX_RESULTS);
-                    break;
-                case 3: // Artista
-                    result_count = search_by_artist(bin_filename, search_term, 
-                                                   shared_data->results, MAX_RESULTS);
-                    break;
-                case 4: // Año
-                    result_count = search_by_year(bin_filename, search_year, 
-                                                 shared_data->results, MAX_RESULTS);
-                    break;
-                case 5: // Estadísticas
-                    {
-                        int total_songs, min_year, max_year;
-                        if (get_database_stats(bin_filename, &total_songs, &min_year, &max_year) == 0) {
-                            result_count = total_songs;
-                            shared_data->results[0].year = min_year;
-                            shared_data->results[0].duration_ms = max_year;
-                        }
-                    }
-                    break;
-            }
+            memset(&g_query, 0, sizeof(g_query));
+            uint64_t query_start = now_ns();
+            int result_count = query.search_type == BATCH_SEARCH_TYPE ?
+                               execute_batch(bin_filename) :
+                               execute_query(bin_filename, &query, shared_data->results);
+            
+            metrics_record(query.search_type, now_ns() - query_start, result_count);
             
             // Guardar resultados
+            uint64_t trace_start = trace_now();
             sem_wait(sem_id);
             shared_data->result_count = result_count;
             shared_data->response_ready = 1; // Respuesta lista
             sem_signal(sem_id);
+            trace_span("result_copy", trace_start);
             
         } else {
             sem_signal(sem_id);
             usleep(1000); // Espera mínima cuando no hay trabajo
         }
     }
+    
+    database_close();
+}
+
+// Asegurar espacio para "extra" bytes más
+int buffer_reserve(ByteBuffer *buffer, size_t extra) {
+    if (buffer->length + extra <= buffer->capacity) return 1;
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+    while (capacity < buffer->length + extra) capacity *= 2;
+    uint8_t *data = realloc(buffer->data, capacity);
+    if (!data) return 0;
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return 1;
+}
+
+int buffer_append(ByteBuffer *buffer, const void *data, size_t size) {
+    if (!buffer_reserve(buffer, size)) return 0;
+    memcpy(buffer->data + buffer->length, data, size);
+    buffer->length += size;
+    return 1;
+}
+
+// Descartar los primeros "size" bytes
+void buffer_consume(ByteBuffer *buffer, size_t size) {
+    memmove(buffer->data, buffer->data + size, buffer->length - size);
+    buffer->length -= size;
+}
+
+// Agregar una respuesta completa al buffer de salida
+int wire_encode_response(ByteBuffer *out, uint32_t request_id, int status, int result_count,
+                         const Song *songs, int song_count) {
+    size_t header_at = out->length;
+    WireResponse header = {0, request_id, status, (uint32_t)result_count, (uint32_t)song_count};
+    if (!buffer_append(out, &header, sizeof(header))) return 0;
+    
+    for (int i = 0; i < song_count; i++) {
+        const Song *song = &songs[i];
+        const char *fields[4] = {song->id, song->name, song->album, song->artists};
+        size_t sizes[4] = {sizeof(song->id), sizeof(song->name), sizeof(song->album),
+                           sizeof(song->artists)};
+        WireSong wire = {song->year, song->duration_ms, song->danceability, song->energy,
+                         song->tempo, {0, 0, 0, 0}};
+        for (int f = 0; f < 4; f++) wire.lengths[f] = (uint16_t)strnlen(fields[f], sizes[f]);
+        
+        if (!buffer_append(out, &wire, sizeof(wire))) return 0;
+        for (int f = 0; f < 4; f++) {
+            if (!buffer_append(out, fields[f], wire.lengths[f])) return 0;
+        }
+    }
+    
+    uint32_t length = (uint32_t)(out->length - header_at);
+    memcpy(out->data + header_at, &length, sizeof(length));
+    return 1;
+}
+
+// Ejecutar una solicitud del socket y encolar su respuesta
+int server_handle_request(const char *bin_filename, const uint8_t *frame, ByteBuffer *out) {
+    static Song results[MAX_RESULTS];
+    WireRequest request;
+    memcpy(&request, frame, sizeof(request));
+    
+    Query query;
+    memset(&query, 0, sizeof(query));
+    query.search_type = request.search_type;
+    query.search_year = request.search_year;
+    query.order_field = request.order_field;
+    query.order_desc = request.order_desc;
+    query.limit = request.limit;
+    size_t term_length = request.term_length < sizeof(query.search_term) - 1 ?
+                         request.term_length : sizeof(query.search_term) - 1;
+    memcpy(query.search_term, frame + sizeof(request), term_length);
+    
+    // Los lotes usan memoria compartida; por el socket basta con encadenar solicitudes
+    if (query.search_type < 1 || query.search_type == BATCH_SEARCH_TYPE ||
+        query.search_type > AGGREGATE_SEARCH_TYPE) {
+        return wire_encode_response(out, request.request_id, WIRE_BAD_REQUEST, 0, NULL, 0);
+    }
+    
+    trace_request_id = request.request_id;
+    memset(&g_query, 0, sizeof(g_query));
+    uint64_t query_start = now_ns();
+    int result_count = execute_query(bin_filename, &query, results);
+    metrics_record(query.search_type, now_ns() - query_start, result_count);
+    
+    // La agregación cuenta todos sus grupos aunque solo se envíen los del límite
+    int song_count = query.search_type == 5 ? 1 : result_count;
+    int limit = query.limit > 0 && query.limit < MAX_RESULTS ? query.limit : MAX_RESULTS;
+    if (song_count > limit) song_count = limit;
+    return wire_encode_response(out, request.request_id, WIRE_OK, result_count, results, song_count);
+}
+
+void connection_close(int epoll_fd, Connection *conn) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+    free(conn->in.data);
+    free(conn->out.data);
+    free(conn);
+}
+
+// Ajustar el interés de epoll: con salida pendiente se espera EPOLLOUT y,
+// si hay demasiada, se deja de leer hasta vaciarla
+void connection_update_events(int epoll_fd, Connection *conn) {
+    uint32_t wanted = conn->out.length < SERVER_MAX_PENDING_OUTPUT ? EPOLLIN : 0;
+    if (conn->out.length > 0) wanted |= EPOLLOUT;
+    if (wanted == conn->events) return;
+    
+    struct epoll_event event;
+    event.data.ptr = conn;
+    event.events = wanted;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, conn->fd, &event);
+    conn->events = wanted;
+}
+
+// Escribir lo posible de la salida; 0 si la conexión falló
+int connection_flush(Connection *conn) {
+    size_t sent = 0;
+    while (sent < conn->out.length) {
+        ssize_t n = write(conn->fd, conn->out.data + sent, conn->out.length - sent);
+        if (n > 0) {
+            sent += n;
+        } else if (n == -1 && errno == EINTR) {
+            continue;
+        } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return 0;
+        }
+    }
+    buffer_consume(&conn->out, sent);
+    return 1;
+}
+
+// Atender todas las solicitudes completas del buffer de entrada (los
+// clientes pueden encadenar varias sin esperar respuesta); las respuestas
+// se acumulan y se envían juntas. 0 si la trama es inválida
+int connection_process(const char *bin_filename, Connection *conn) {
+    size_t offset = 0;
+    while (conn->in.length - offset >= sizeof(WireRequest) &&
+           conn->out.length < SERVER_MAX_PENDING_OUTPUT) {
+        WireRequest request;
+        memcpy(&request, conn->in.data + offset, sizeof(request));
+        if (request.length != sizeof(WireRequest) + request.term_length ||
+            request.term_length >= sizeof(((Query*)0)->search_term)) {
+            return 0;
+        }
+        if (conn->in.length - offset < request.length) break;
+        
+        if (!server_handle_request(bin_filename, conn->in.data + offset, &conn->out)) return 0;
+        offset += request.length;
+    }
+    buffer_consume(&conn->in, offset);
+    return 1;
+}
+
+void server_signal_handler(int sig) {
+    (void)sig;
+    server_running = 0;
+}
+
+// Servidor: el proceso de búsqueda como demonio independiente que atiende
+// el protocolo binario en un socket Unix con un bucle epoll
+int socket_server_process(const char *socket_path) {
+    const char *bin_filename = "songs_database.bin";
+    printf("Servidor de búsqueda iniciado (PID: %d)\n", getpid());
+    
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        printf("Ruta de socket demasiado larga: %s\n", socket_path);
+        return 1;
+    }
+    strcpy(address.sun_path, socket_path);
+    
+    if (database_open(bin_filename) < 0) return 1;
+    
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd == -1) {
+        perror("Error creando socket");
+        database_close();
+        return 1;
+    }
+    unlink(socket_path);
+    if (bind(listen_fd, (struct sockaddr*)&address, sizeof(address)) == -1 ||
+        listen(listen_fd, SOMAXCONN) == -1) {
+        perror("Error escuchando en el socket");
+        close(listen_fd);
+        database_close();
+        return 1;
+    }
+    
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL; // NULL = socket de escucha
+    if (epoll_fd == -1 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) == -1) {
+        perror("Error creando epoll");
+        close(listen_fd);
+        unlink(socket_path);
+        database_close();
+        return 1;
+    }
+    
+    signal(SIGINT, server_signal_handler);
+    signal(SIGTERM, server_signal_handler);
+    signal(SIGPIPE, SIG_IGN);
+    printf("Escuchando en %s\n", socket_path);
+    fflush(stdout);
+    
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while (server_running) {
+        int ready = epoll_wait(epoll_fd, events, SERVER_MAX_EVENTS, -1);
+        if (ready == -1) {
+            if (errno == EINTR) continue;
+            perror("Error en epoll_wait");
+            break;
+        }
+        
+        for (int i = 0; i < ready; i++) {
+            Connection *conn = events[i].data.ptr;
+            
+            // Nuevas conexiones
+            if (!conn) {
+                int fd;
+                while ((fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+                    conn = calloc(1, sizeof(Connection));
+                    if (!conn) {
+                        close(fd);
+                        continue;
+                    }
+                    conn->fd = fd;
+                    conn->events = EPOLLIN;
+                    event.events = EPOLLIN;
+                    event.data.ptr = conn;
+                    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+                        close(fd);
+                        free(conn);
+                    }
+                }
+                continue;
+            }
+            
+            int ok = 1;
+            if (events[i].events & EPOLLIN) {
+                if (!buffer_reserve(&conn->in, SERVER_READ_CHUNK)) {
+                    ok = 0;
+                } else {
+                    ssize_t n = read(conn->fd, conn->in.data + conn->in.length, SERVER_READ_CHUNK);
+                    if (n > 0) conn->in.length += n;
+                    else if (n == 0 || (errno != EAGAIN && errno != EINTR)) ok = 0;
+                }
+            } else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                ok = 0;
+            }
+            
+            // Procesar lo recibido (o lo que quedó esperando a que se vaciara la
+            // salida). Si el envío vacía la salida, se siguen atendiendo las
+            // tramas completas pendientes: el cliente puede no mandar nada más
+            while (ok) {
+                size_t pending = conn->in.length;
+                ok = connection_process(bin_filename, conn);
+                if (ok && conn->out.length > 0) ok = connection_flush(conn);
+                if (conn->out.length > 0 || conn->in.length == pending) break;
+            }
+            
+            if (!ok) {
+                connection_close(epoll_fd, conn);
+            } else {
+                connection_update_events(epoll_fd, conn);
+            }
+        }
+    }
+    
+    printf("\nDeteniendo servidor...\n");
+    close(epoll_fd);
+    close(listen_fd);
+    unlink(socket_path);
+    database_close();
+    return 0;
+}
+
+// Decodificar una canción de una respuesta y avanzar *data; 0 si está truncada
+int wire_decode_song(const uint8_t **data, const uint8_t *end, Song *song) {
+    WireSong wire;
+    if ((size_t)(end - *data) < sizeof(wire)) return 0;
+    memcpy(&wire, *data, sizeof(wire));
+    *data += sizeof(wire);
+    
+    memset(song, 0, sizeof(Song));
+    char *fields[4] = {song->id, song->name, song->album, song->artists};
+    size_t sizes[4] = {sizeof(song->id), sizeof(song->name), sizeof(song->album),
+                       sizeof(song->artists)};
+    for (int f = 0; f < 4; f++) {
+        if (wire.lengths[f] >= sizes[f] || (size_t)(end - *data) < wire.lengths[f]) return 0;
+        memcpy(fields[f], *data, wire.lengths[f]);
+        *data += wire.lengths[f];
+    }
+    
+    song->year = wire.year;
+    song->duration_ms = wire.duration_ms;
+    song->danceability = wire.danceability;
+    song->energy = wire.energy;
+    song->tempo = wire.tempo;
+    return 1;
+}
+
+// Escribir una respuesta completa con la salida del modo por lotes; 0 si está dañada
+int client_handle_response(const uint8_t *frame, const WireResponse *header, const Query *query) {
+    const uint8_t *data = frame + sizeof(WireResponse);
+    const uint8_t *end = frame + header->length;
+    Song song;
+    memset(&song, 0, sizeof(song));
+    
+    for (uint32_t i = 0; i < header->song_count; i++) {
+        if (!wire_decode_song(&data, end, &song)) return 0;
+        if (query->search_type != 5) batch_write(stdout, header->request_id + 1, query, &song);
+    }
+    
+    if (header->status != WIRE_OK) {
+        printf("# %u. consulta rechazada por el servidor\n", header->request_id + 1);
+    } else if (query->search_type == AGGREGATE_SEARCH_TYPE && header->song_count < header->result_count) {
+        printf("# %u. se devuelven %u de %u grupos\n", header->request_id + 1,
+               header->song_count, header->result_count);
+    } else if (query->search_type == 5) {
+        printf("%u\t%u\t%d\t%d\n", header->request_id + 1, header->result_count,
+               song.year, song.duration_ms);
+    }
+    return 1;
+}
+
+// Cliente del servidor: envía todas las consultas encadenadas, sin esperar
+// cada respuesta, con la misma salida que el modo por lotes. Escritura y
+// lectura se alternan con poll: si el servidor deja de leer porque acumuló
+// demasiada salida, el cliente sigue leyendo respuestas en vez de quedarse
+// bloqueado en la escritura
+int socket_client_process(const char *socket_path, char **specs, int spec_count,
+                          const char *batch_file, int limit) {
+    static Query queries[BATCH_MAX];
+    int count = 0;
+    int errors = 0;
+    
+    for (int i = 0; i < spec_count && count < BATCH_MAX; i++) {
+        if (parse_batch_query(specs[i], &queries[count], limit)) {
+            count++;
+        } else {
+            printf("Consulta inválida: %s\n", specs[i]);
+            errors++;
+        }
+    }
+    if (batch_file) {
+        FILE *file = fopen(batch_file, "r");
+        if (!file) {
+            printf("Error abriendo archivo de consultas: %s\n", batch_file);
+            return 1;
+        }
+        char line[512];
+        while (count < BATCH_MAX && fgets(line, sizeof(line), file)) {
+            line[strcspn(line, "\r\n")] = '\0';
+            if (line[0] == '\0' || line[0] == '#') continue;
+            if (parse_batch_query(line, &queries[count], limit)) {
+                count++;
+            } else {
+                printf("Consulta inválida: %s\n", line);
+                errors++;
+            }
+        }
+        fclose(file);
+    }
+    if (count == 0) return 1;
+    
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socket_path, sizeof(address.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1 || connect(fd, (struct sockaddr*)&address, sizeof(address)) == -1) {
+        perror("Error conectando con el servidor");
+        if (fd != -1) close(fd);
+        return 1;
+    }
+    
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    // Todas las solicitudes encadenadas
+    ByteBuffer out = {NULL, 0, 0};
+    for (int q = 0; q < count; q++) {
+        WireRequest request;
+        memset(&request, 0, sizeof(request));
+        request.term_length = (uint16_t)strlen(queries[q].search_term);
+        request.length = sizeof(request) + request.term_length;
+        request.request_id = (uint32_t)q;
+        request.search_type = (uint8_t)queries[q].search_type;
+        request.search_year = queries[q].search_year;
+        request.limit = (uint16_t)(queries[q].limit > 0 && queries[q].limit < MAX_RESULTS ?
+                                   queries[q].limit : MAX_RESULTS);
+        if (!buffer_append(&out, &request, sizeof(request)) ||
+            !buffer_append(&out, queries[q].search_term, request.term_length)) {
+            printf("Error: memoria insuficiente\n");
+            free(out.data);
+            close(fd);
+            return 1;
+        }
+    }
+    
+    // Respuestas a medida que llegan (se identifican por request_id)
+    static int result_counts[BATCH_MAX];
+    ByteBuffer in = {NULL, 0, 0};
+    size_t sent = 0;
+    int received = 0;
+    int total = 0;
+    while (received < count) {
+        struct pollfd poller = {fd, POLLIN, 0};
+        if (sent < out.length) poller.events |= POLLOUT;
+        if (poll(&poller, 1, -1) == -1) {
+            if (errno == EINTR) continue;
+            perror("Error en poll");
+            errors++;
+            break;
+        }
+        
+        if (poller.revents & POLLOUT) {
+            ssize_t n = write(fd, out.data + sent, out.length - sent);
+            if (n > 0) {
+                sent += n;
+            } else if (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                perror("Error enviando consultas");
+                errors++;
+                break;
+            }
+        }
+        
+        if (poller.revents & (POLLIN | POLLHUP | POLLERR)) {
+            if (!buffer_reserve(&in, SERVER_READ_CHUNK)) {
+                printf("Error: memoria insuficiente\n");
+                errors++;
+                break;
+            }
+            ssize_t n = read(fd, in.data + in.length, SERVER_READ_CHUNK);
+            if (n > 0) {
+                in.length += n;
+            } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                printf("Error: respuesta incompleta del servidor\n");
+                errors++;
+                break;
+            }
+        }
+        
+        size_t offset = 0;
+        int ok = 1;
+        while (received < count && in.length - offset >= sizeof(WireResponse)) {
+            WireResponse header;
+            memcpy(&header, in.data + offset, sizeof(header));
+            if (header.length < sizeof(header) || header.request_id >= (uint32_t)count) {
+                ok = 0;
+                break;
+            }
+            if (in.length - offset < header.length) break;
+            
+            const Query *query = &queries[header.request_id];
+            if (!client_handle_response(in.data + offset, &header, query)) {
+                ok = 0;
+                break;
+            }
+            if (header.status != WIRE_OK) errors++;
+            result_counts[header.request_id] = (int)header.result_count;
+            total += query->search_type == 5 ? 1 : (int)header.song_count;
+            received++;
+            offset += header.length;
+        }
+        buffer_consume(&in, offset);
+        if (!ok) {
+            printf("Error: respuesta incompleta del servidor\n");
+            errors++;
+            break;
+        }
+    }
+    free(out.data);
+    free(in.data);
+    close(fd);
+    
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("# Servidor: %d consultas, %d resultados en %.3f segundos\n", received, total,
+           (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+    for (int q = 0; q < count; q++) {
+        printf("# %d. %s: %d resultados\n", q + 1,
+               queries[q].search_type == 5 ? "estadísticas" : queries[q].search_term,
+               result_counts[q]);
+    }
+    return errors > 0;
+}
+
+void usage(const char *prog) {
+    printf("Uso: %s [-t archivo_trazas] [-m memoria] [-D]\n", prog);
+    printf("  -t F  Registrar trazas (CLOCK_MONOTONIC) en formato Chrome trace JSON\n");
+    printf("  -m N  Presupuesto de memoria en bytes: buffer pool, índices en memoria y tablas\n");
+    printf("        de agregación (sufijos K, M; 0 = sin pool ni límite; por defecto %ldM)\n",
+           POOL_DEFAULT_BUDGET / (1024 * 1024));
+    printf("  -D    Leer la base con O_DIRECT (sin caché de páginas del kernel)\n");
+    printf("Modo por lotes (sin menú): todas las consultas se envían juntas\n");
+    printf("  -q C  Consulta \"tipo:valor\" (nombre, palabra, artista, año, estadisticas,\n");
+    printf("        aproximada, similares, autocompletar, agregar); se puede repetir\n");
+    printf("        agregar:funcion:campo:grupo, p. ej. \"agregar:avg:energia:año\"\n");
+    printf("  -b F  Archivo con una consulta por línea ('#' para comentarios)\n");
+    printf("  -n N  Máximo de resultados por consulta (por defecto %d; 0 = sin límite). Solo\n", MAX_RESULTS);
+    printf("        nombre, palabra, artista, año y agregar pasan de %d; los demás tipos\n", MAX_RESULTS);
+    printf("        y el servidor devuelven como máximo %d\n", MAX_RESULTS);
+    printf("  -o F  Escribir las coincidencias en F en lugar de la salida estándar\n");
+    printf("Servidor (socket Unix, sin memoria compartida SysV):\n");
+    printf("  -S P  Ejecutar solo el proceso de búsqueda como servidor en el socket P\n");
+    printf("  -C P  Enviar las consultas de -q / -b al servidor del socket P\n");
+}
+
+// Tamaño con sufijo opcional K o M; -1 si no es válido
+long parse_size(const char *text) {
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (end == text || value < 0) return -1;
+    if (*end == 'k' || *end == 'K') {
+        value *= 1024;
+        end++;
+    } else if (*end == 'm' || *end == 'M') {
+        value *= 1024 * 1024;
+        end++;
+    }
+    return *end == '\0' ? value : -1;
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    const char *trace_file = NULL;
+    char *batch_specs[BATCH_MAX];
+    int batch_spec_count = 0;
+    const char *batch_file = NULL;
+    const char *batch_output = NULL;
+    int batch_limit = MAX_RESULTS;
+    const char *server_socket = NULL;
+    const char *client_socket = NULL;
+    int opt;
+    
+    while ((opt = getopt(argc, argv, "t:m:Dq:b:n:o:S:C:h")) != -1) {
+        switch (opt) {
+            case 't':
+                trace_file = optarg;
+                break;
+            case 'm':
+                memory_budget = parse_size(optarg);
+                if (memory_budget < 0) {
+                    printf("Tamaño inválido: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'D':
+                pool_direct = 1;
+                break;
+            case 'q':
+                if (batch_spec_count < BATCH_MAX) batch_specs[batch_spec_count++] = optarg;
+                break;
+            case 'b':
+                batch_file = optarg;
+                break;
+            case 'n':
+                {
+                    char *end;
+                    long value = strtol(optarg, &end, 10);
+                    if (end == optarg || *end != '\0' || value < 0 || value > INT_MAX) {
+                        printf("Límite inválido: %s\n", optarg);
+                        return 1;
+                    }
+                    batch_limit = (int)value;
+                }
+                break;
+            case 'o':
+                batch_output = optarg;
+                break;
+            case 'S':
+                server_socket = optarg;
+                break;
+            case 'C':
+                client_socket = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    
+    // Cliente del servidor: no usa el canal de memoria compartida
+    if (client_socket) {
+        if (batch_spec_count == 0 && !batch_file) {
+            printf("El modo cliente necesita consultas con -q o -b\n");
+            return 1;
+        }
+        return socket_client_process(client_socket, batch_specs, batch_spec_count,
+                                     batch_file, batch_limit);
+    }
+    
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
     
-    // Crear memoria compartida
-    shm_id = shmget(SHM_KEY, sizeof(SharedData), IPC_CREAT | 0666);
+    // Servidor independiente: solo el proceso de búsqueda, sin canal SysV
+    if (server_socket) {
+        if (trace_file) trace_open(trace_file, "servidor");
+        metrics_init();
+        int status = socket_server_process(server_socket);
+        trace_dump();
+        if (trace_file) trace_close();
+        if (metrics_shm_id != -1) {
+            shmdt(metrics);
+            shmctl(metrics_shm_id, IPC_RMID, NULL);
+        }
+        return status;
+    }
+    
+    if (trace_file) {
+        trace_open(trace_file, "interfaz");
+    }
+    
+    // Crear memoria compartida. El canal y el semáforo son privados de esta
+    // instancia (el proceso de búsqueda los hereda con fork), así que varias
+    // instancias no comparten solicitudes
+    shm_id = shmget(IPC_PRIVATE, sizeof(SharedData), IPC_CREAT | 0600);
     if (shm_id == -1) {
         perror("Error creando memoria compartida");
         return 1;
@@ -616,7 +4550,7 @@ int main() {
     shared_data->shutdown = 0;
     
     // Crear semáforo
-    sem_id = semget(SEM_KEY, 1, IPC_CREAT | 0666);
+    sem_id = semget(IPC_PRIVATE, 1, IPC_CREAT | 0600);
     if (sem_id == -1) {
         perror("Error creando semáforo");
         cleanup();
@@ -630,20 +4564,35 @@ int main() {
         return 1;
     }
     
-    // Crear proceso de base de datos
+    // Página de métricas para dbstat
+    metrics_init();
+    
+    // Crear proceso de base de datos (sin salida pendiente que el hijo duplicaría)
+    fflush(stdout);
     db_pid = fork();
     if (db_pid == 0) {
         // Proceso hijo - base de datos
+        trace_reset("busqueda");
         database_process();
+        trace_dump();
         exit(0);
     } else if (db_pid > 0) {
-        // Proceso padre - interfaz de usuario
+        int status = 0;
+        
+        // Proceso padre - interfaz de usuario o cliente por lotes
         printf("Iniciando interfaz de usuario...\n");
         sleep(1); // Esperar a que la BD se inicialice
         
-        user_interface_process();
+        if (batch_spec_count > 0 || batch_file) {
+            status = batch_client_process(batch_specs, batch_spec_count, batch_file,
+                                          batch_limit, batch_output);
+        } else {
+            user_interface_process();
+        }
         
+        trace_dump();
         cleanup();
+        return status;
     } else {
         perror("Error creando proceso");
         cleanup();